@@ -11,12 +11,19 @@
 #include <condition_variable> // NOLINT
 #include <fstream>
 #include <queue>
+#include <deque>
 #include <chrono>
 #include <ctime>
 #include <stdio.h>
 #include <cstdint>
 #include <cstring>
 #include <future> // NOLINT
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <limits>
+#include <algorithm>
+#include <type_traits>
 #include <cstdio>
 #include <mlpack/core.hpp>
 #include <sys/stat.h>
@@ -28,6 +35,9 @@
 #ifdef _WIN32
   #include <io.h>
   #include <direct.h>
+  #include <process.h>
+#else
+  #include <unistd.h>
 #endif
 
 #endif
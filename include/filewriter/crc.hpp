@@ -8,6 +8,7 @@
 #include <mlboard/core.hpp>
 
 int crc32file(char *name, uint32_t *crc, long *charcnt);
+uint32_t crc32c(uint32_t crc, const char *buf, size_t len);
 uint32_t crc32buf(const char *buf, size_t len);
 uint32_t masked_crc32c(const char *buf, size_t len);
 
@@ -175,18 +175,257 @@ inline int crc32file(char *name, uint32_t *crc, long *charcnt)
       return 0;
 }
 
-inline uint32_t crc32buf(const char *buf, size_t len)
+/* Slicing-by-8 tables: crc_32_tab extended to eight bytes at a time.  Entry */
+/* [k][n] is the CRC of byte n followed by k zero bytes.                     */
+struct crc32c_slicing_tables
 {
-      uint32_t oldcrc32;
+      uint32_t tab[8][256];
+
+      crc32c_slicing_tables()
+      {
+            for (int n = 0; n < 256; n++)
+                  tab[0][n] = crc_32_tab[n];
+            for (int k = 1; k < 8; k++)
+                  for (int n = 0; n < 256; n++)
+                        tab[k][n] = (tab[k - 1][n] >> 8) ^
+                            crc_32_tab[tab[k - 1][n] & 0xff];
+      }
+};
+
+inline const crc32c_slicing_tables& crc32c_tables()
+{
+      static const crc32c_slicing_tables tables;
+      return tables;
+}
+
+/* Table driven CRC32C, eight bytes at a time.  Takes and returns the CRC */
+/* register (not inverted).                                               */
+inline uint32_t crc32c_sw(uint32_t crc, const char *buf, size_t len)
+{
+      const unsigned char *next = (const unsigned char *) buf;
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+      for ( ; len; --len, ++next)
+            crc = UPDC32(*next, crc);
+#else
+      const uint32_t (*tab)[256] = crc32c_tables().tab;
+      for ( ; len >= 8; len -= 8, next += 8)
+      {
+            uint64_t word;
+            std::memcpy(&word, next, sizeof(uint64_t));
+            word ^= crc;
+            crc = tab[7][word & 0xff] ^
+                  tab[6][(word >> 8) & 0xff] ^
+                  tab[5][(word >> 16) & 0xff] ^
+                  tab[4][(word >> 24) & 0xff] ^
+                  tab[3][(word >> 32) & 0xff] ^
+                  tab[2][(word >> 40) & 0xff] ^
+                  tab[1][(word >> 48) & 0xff] ^
+                  tab[0][word >> 56];
+      }
+      for ( ; len; --len, ++next)
+            crc = UPDC32(*next, crc);
+#endif
+
+      return crc;
+}
+
+#if (defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))) || \
+    defined(_M_X64)
+#define MLBOARD_CRC32C_SSE42
+
+#if defined(_MSC_VER)
+  #include <intrin.h>
+  #include <nmmintrin.h>
+  #define MLBOARD_TARGET_SSE42
+#else
+  #include <cpuid.h>
+  #include <nmmintrin.h>
+  #define MLBOARD_TARGET_SSE42 __attribute__((target("sse4.2")))
+#endif
+
+/* The hardware version computes three streams at once to hide the latency */
+/* of the crc32 instruction, and combines them by shifting the CRC of the   */
+/* first streams over the length of the following ones.  The shift is the  */
+/* multiplication with the operator for a run of zero bytes, which is       */
+/* stored for LONG and SHORT bytes in tables four bytes wide.  Adapted from */
+/* crc32c.c by Mark Adler.                                                  */
+#define CRC32C_LONG 8192
+#define CRC32C_SHORT 256
+
+inline uint32_t gf2_matrix_times(const uint32_t *mat, uint32_t vec)
+{
+      uint32_t sum = 0;
+      while (vec)
+      {
+            if (vec & 1)
+                  sum ^= *mat;
+            vec >>= 1;
+            mat++;
+      }
+      return sum;
+}
+
+inline void gf2_matrix_square(uint32_t *square, const uint32_t *mat)
+{
+      for (int n = 0; n < 32; n++)
+            square[n] = gf2_matrix_times(mat, mat[n]);
+}
+
+/* Operator for len zero bytes, len a power of two. */
+inline void crc32c_zeros_op(uint32_t *even, size_t len)
+{
+      uint32_t odd[32];
+
+      /* Operator for one zero bit in odd. */
+      odd[0] = 0x82f63b78;
+      uint32_t row = 1;
+      for (int n = 1; n < 32; n++)
+      {
+            odd[n] = row;
+            row <<= 1;
+      }
+
+      /* Two zero bits in even, four in odd. */
+      gf2_matrix_square(even, odd);
+      gf2_matrix_square(odd, even);
 
-      oldcrc32 = 0xFFFFFFFF;
+      /* The first square puts one zero byte in even, the next two in odd, */
+      /* and so on until len has been rotated down to zero.                */
+      do
+      {
+            gf2_matrix_square(even, odd);
+            len >>= 1;
+            if (len == 0)
+                  return;
+            gf2_matrix_square(odd, even);
+            len >>= 1;
+      } while (len);
+
+      for (int n = 0; n < 32; n++)
+            even[n] = odd[n];
+}
+
+struct crc32c_shift_tables
+{
+      uint32_t longTab[4][256];
+      uint32_t shortTab[4][256];
 
-      for ( ; len; --len, ++buf)
+      crc32c_shift_tables()
       {
-            oldcrc32 = UPDC32(*buf, oldcrc32);
+            Fill(longTab, CRC32C_LONG);
+            Fill(shortTab, CRC32C_SHORT);
       }
 
-      return ~oldcrc32;
+      static void Fill(uint32_t zeros[][256], size_t len)
+      {
+            uint32_t op[32];
+            crc32c_zeros_op(op, len);
+            for (uint32_t n = 0; n < 256; n++)
+            {
+                  zeros[0][n] = gf2_matrix_times(op, n);
+                  zeros[1][n] = gf2_matrix_times(op, n << 8);
+                  zeros[2][n] = gf2_matrix_times(op, n << 16);
+                  zeros[3][n] = gf2_matrix_times(op, n << 24);
+            }
+      }
+};
+
+inline uint32_t crc32c_shift(const uint32_t zeros[][256], uint32_t crc)
+{
+      return zeros[0][crc & 0xff] ^ zeros[1][(crc >> 8) & 0xff] ^
+             zeros[2][(crc >> 16) & 0xff] ^ zeros[3][crc >> 24];
+}
+
+/* Hardware CRC32C with the SSE 4.2 crc32 instruction.  Takes and returns */
+/* the CRC register (not inverted).                                       */
+MLBOARD_TARGET_SSE42
+inline uint32_t crc32c_hw(uint32_t crc, const char *buf, size_t len)
+{
+      static const crc32c_shift_tables shift;
+      const unsigned char *next = (const unsigned char *) buf;
+      uint64_t crc0 = crc, crc1, crc2, word;
+
+      /* Align to eight bytes. */
+      while (len && ((uintptr_t) next & 7) != 0)
+      {
+            crc0 = _mm_crc32_u8((uint32_t) crc0, *next);
+            next++;
+            len--;
+      }
+
+      /* Three streams of LONG bytes, then of SHORT bytes. */
+      const size_t blocks[2] = { CRC32C_LONG, CRC32C_SHORT };
+      const uint32_t (*zeros[2])[256] = { shift.longTab, shift.shortTab };
+      for (int b = 0; b < 2; b++)
+      {
+            const size_t block = blocks[b];
+            while (len >= block * 3)
+            {
+                  crc1 = 0;
+                  crc2 = 0;
+                  const unsigned char *end = next + block;
+                  do
+                  {
+                        std::memcpy(&word, next, sizeof(uint64_t));
+                        crc0 = _mm_crc32_u64(crc0, word);
+                        std::memcpy(&word, next + block, sizeof(uint64_t));
+                        crc1 = _mm_crc32_u64(crc1, word);
+                        std::memcpy(&word, next + 2 * block, sizeof(uint64_t));
+                        crc2 = _mm_crc32_u64(crc2, word);
+                        next += 8;
+                  } while (next < end);
+                  crc0 = crc32c_shift(zeros[b], (uint32_t) crc0) ^ crc1;
+                  crc0 = crc32c_shift(zeros[b], (uint32_t) crc0) ^ crc2;
+                  next += block * 2;
+                  len -= block * 3;
+            }
+      }
+
+      /* The rest, eight bytes at a time. */
+      for ( ; len >= 8; len -= 8, next += 8)
+      {
+            std::memcpy(&word, next, sizeof(uint64_t));
+            crc0 = _mm_crc32_u64(crc0, word);
+      }
+      for ( ; len; --len, ++next)
+            crc0 = _mm_crc32_u8((uint32_t) crc0, *next);
+
+      return (uint32_t) crc0;
+}
+
+inline bool crc32c_hw_supported()
+{
+#if defined(_MSC_VER)
+      int info[4];
+      __cpuid(info, 1);
+      return (info[2] & (1 << 20)) != 0;
+#else
+      unsigned int eax, ebx, ecx, edx;
+      if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+            return false;
+      return (ecx & bit_SSE4_2) != 0;
+#endif
+}
+#endif /* MLBOARD_CRC32C_SSE42 */
+
+/* CRC32C of the buffer, chained from a previous CRC (0 to start).  The */
+/* implementation is picked once, on the first call.                   */
+inline uint32_t crc32c(uint32_t crc, const char *buf, size_t len)
+{
+      typedef uint32_t (*crc32c_func)(uint32_t, const char *, size_t);
+#ifdef MLBOARD_CRC32C_SSE42
+      static const crc32c_func func =
+          crc32c_hw_supported() ? crc32c_hw : crc32c_sw;
+#else
+      static const crc32c_func func = crc32c_sw;
+#endif
+      return ~func(~crc, buf, len);
+}
+
+inline uint32_t crc32buf(const char *buf, size_t len)
+{
+      return crc32c(0, buf, len);
 }
 
 inline uint32_t masked_crc32c(const char *buf, size_t len) {
@@ -7,7 +7,10 @@
 
 #include <mlboard/core.hpp>
 #include <proto/event.pb.h>
+#include <google/protobuf/arena.h>
 #include "sharedqueue.hpp"
+#include "ringqueue.hpp"
+#include "util.hpp"
 
 #include "crc.hpp"
 
@@ -17,8 +20,19 @@ namespace mlboard {
  * Class responsible for writing the event to a event file. The writing is a
  * async operation which is running a separte thread. Look writeSummary()
  * for more information.
+ *
+ * @tparam QueueType The queue that holds the events until they are written.
+ *    SharedQueue guards a std::queue with a lock, while RingQueue is a
+ *    lock-free alternative for many threads logging at the same time. If the
+ *    queue holds mlboard::Event, the events are serialized by the writer
+ *    thread; if it holds std::string, every thread that logs a summary
+ *    serializes and checksums its own records, and the writer thread only
+ *    writes them. If it holds mlboard::Event*, summaries and events are built
+ *    on protobuf arenas, which are handed back for reuse after every batch
+ *    written by the writer thread.
  */
-class FileWriter
+template<typename QueueType = SharedQueue<mlboard::Event>>
+class FileWriterType
 {
  public:
  /**
@@ -27,15 +41,23 @@ class FileWriter
   * @param logdir Path to store the log files.
   * @param maxQeueSize The maximum number of event to be store at a time.
   * @param flushmilis Interval to perform the writing operation (milliseconds).
+  * @param flushBytes Number of bytes to write before the file stream is
+  *     flushed (0 flushes after every batch of events). If no more events
+  *     are logged, the written ones are flushed after flushmilis.
+  * @param flushIntervalMilis Interval between two flushes of the file stream
+  *     (milliseconds, 0 flushes after every batch of events). Written events
+  *     are flushed when the interval passes, even if no more are logged.
   */
-  FileWriter(std::string logdir = "./",
-             int maxQueueSize = 10,
-             size_t flushmilis = 5000);
+  FileWriterType(std::string logdir = "./",
+                 int maxQueueSize = 10,
+                 size_t flushmilis = 5000,
+                 size_t flushBytes = 0,
+                 size_t flushIntervalMilis = 0);
 
  /**
   * Destructor Responsible for filewriter object.
   */
-  ~FileWriter();
+  ~FileWriterType();
 
   /**
    * A function to write the event in queue to event files. This function
@@ -44,6 +66,13 @@ class FileWriter
    */
   void WriteSummary();
 
+  /**
+   * A helper function to create the summary that is later passed to
+   * CreateEvent(). The summary is allocated on an arena if the queue holds
+   * mlboard::Event*, and on the heap otherwise.
+   */
+  mlboard::Summary* NewSummary();
+
   /**
    * A helper function to change summary to event. The function should
    * always be there, since it is called from the summary instance.
@@ -53,6 +82,16 @@ class FileWriter
    */
   void CreateEvent(size_t step, mlboard::Summary *summary);
 
+  /**
+   * A function to encode a serialized event as a record of the event file
+   * and append it to the given buffer. A record holds the length of the data,
+   * the masked CRC of the length, the data and the masked CRC of the data.
+   *
+   * @param data Serialized event.
+   * @param buffer Output buffer the record is appended to.
+   */
+  static void EncodeRecord(const std::string& data, std::string& buffer);
+
   /**
    * A function to flush everything successfully and close the thread.
    */
@@ -66,17 +105,106 @@ class FileWriter
   //! Get the path of log directory.
   std::string LogDir() const { return logdir; }
   //! Get the filename where event is being written to.
-  std::string FileName() const { return filename; }
+  std::string FileName() const
+  {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    return filename;
+  }
+  //! Get the filenames of all the event files that are kept, oldest first.
+  std::vector<std::string> FileNames() const
+  {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    return std::vector<std::string>(files.begin(), files.end());
+  }
   //! Modify the flushmilis.
   size_t& FlushMilis() { return flushmilis; }
   //! Get the flushmilis.
   size_t FlushMilis() const { return flushmilis; }
+  //! Modify the number of bytes written between two flushes.
+  size_t& FlushBytes() { return flushBytes; }
+  //! Get the number of bytes written between two flushes.
+  size_t FlushBytes() const { return flushBytes; }
+  //! Modify the interval between two flushes.
+  size_t& FlushIntervalMilis() { return flushIntervalMilis; }
+  //! Get the interval between two flushes.
+  size_t FlushIntervalMilis() const { return flushIntervalMilis; }
+  //! Modify the size in bytes after which a new event file is started (0
+  //! never starts a new file because of its size). Set it before logging.
+  size_t& MaxFileBytes() { return maxFileBytes; }
+  //! Get the size in bytes after which a new event file is started.
+  size_t MaxFileBytes() const { return maxFileBytes; }
+  //! Modify the time after which a new event file is started (milliseconds,
+  //! 0 never starts a new file because of its age). Set it before logging.
+  size_t& RotateMilis() { return rotateMilis; }
+  //! Get the time after which a new event file is started.
+  size_t RotateMilis() const { return rotateMilis; }
+  //! Modify the number of event files that are kept; the oldest files are
+  //! removed (0 keeps every file). Set it before logging.
+  size_t& MaxFiles() { return maxFiles; }
+  //! Get the number of event files that are kept.
+  size_t MaxFiles() const { return maxFiles; }
   //! Get the maximum size of the queue.
   size_t MaxSize() const { return q.MaxSize(); }
-  //! Modify the maximum size of the queue.
-  size_t& MaxSize() { return q.MaxSize(); }
+  //! Modify the maximum size of the queue, if the queue allows it; a
+  //! RingQueue has a fixed size, and only returns it.
+  auto MaxSize() -> decltype(std::declval<QueueType&>().MaxSize())
+  { return q.MaxSize(); }
  private:
-  SharedQueue<mlboard::Event> q;
+  //! The type of the records in the queue, either events or encoded records.
+  typedef typename QueueType::ElemType RecordType;
+
+  //! Whether the summaries and events are built on arenas.
+  static const bool useArena =
+      std::is_same<RecordType, mlboard::Event*>::value;
+
+  //! Fill the event for the given summary.
+  static void FillEvent(size_t step,
+                        mlboard::Summary* summary,
+                        mlboard::Event& event);
+
+  //! Turn a summary into a record of the queue, held by value.
+  static void MakeRecord(size_t step,
+                         mlboard::Summary* summary,
+                         mlboard::Event& record);
+
+  //! Turn a summary into a record of the queue, by serializing and encoding
+  //! its event.
+  static void MakeRecord(size_t step,
+                         mlboard::Summary* summary,
+                         std::string& record);
+
+  //! Turn a summary into a record of the queue, allocated on the arena of
+  //! the summary.
+  static void MakeRecord(size_t step,
+                         mlboard::Summary* summary,
+                         mlboard::Event*& record);
+
+  //! Append a queued event to the buffer, using data as scratch space.
+  void AppendRecord(const mlboard::Event& record,
+                    std::string& data,
+                    std::string& buffer);
+
+  //! Append an encoded record to the buffer.
+  void AppendRecord(const std::string& record,
+                    std::string& data,
+                    std::string& buffer);
+
+  //! Append an event allocated on an arena to the buffer; the arena is
+  //! released after the batch is written.
+  void AppendRecord(mlboard::Event* record,
+                    std::string& data,
+                    std::string& buffer);
+
+  //! Make the arenas of the written batch available again.
+  void ReleaseArenas();
+
+  //! Close the current event file and start the next one, removing the
+  //! oldest files beyond MaxFiles().
+  void RotateFile();
+
+  //! Queue holding the events until they are written.
+  QueueType q;
+
   //! Thread which would be running to write the events to the file.
   //! Note: std::thread does not have copy constructor hence pointer is safe.
   std::thread *thread_;
@@ -84,22 +212,68 @@ class FileWriter
   //! Time difference between the two write events.
   std::size_t flushmilis;
 
+  //! Number of bytes to write before the file stream is flushed.
+  std::size_t flushBytes;
+
+  //! Time difference between two flushes of the file stream.
+  std::size_t flushIntervalMilis;
+
   //! Path of the folder where the events file will be written.
   std::string logdir;
 
   //! File name to which the thread is currently writing to.
   std::string filename;
 
-  //! Time for next write operation of events in a file.
-  std::time_t nexttime;
+  //! File name of the first event file; the next files add a counter to it.
+  std::string baseFilename;
+
+  //! Event files that are kept, oldest first.
+  std::deque<std::string> files;
+
+  //! Number of files started after the first one.
+  size_t fileIndex;
+
+  //! Lock for the file names, which change when a new file is started.
+  mutable std::mutex fileMutex;
+
+  //! Size in bytes after which a new event file is started.
+  std::size_t maxFileBytes;
+
+  //! Time after which a new event file is started.
+  std::size_t rotateMilis;
+
+  //! Number of event files that are kept.
+  std::size_t maxFiles;
 
   //! Filestream object that would help writing the events to the file.
   std::ofstream outfile;
 
+  //! Records of the current batch, written to the file at once.
+  std::string buffer;
+
   //! A flag that indicates that logging has been completed succesfully.
   bool close_;
+
+  //! Initial blocks of the arenas, so that a reset arena doesn't need to
+  //! allocate memory for small summaries.
+  std::vector<std::unique_ptr<char[]>> arenaBlocks;
+
+  //! All the arenas created by the filewriter.
+  std::vector<std::unique_ptr<google::protobuf::Arena>> arenas;
+
+  //! Arenas that are ready to be used for a new summary.
+  std::vector<google::protobuf::Arena*> freeArenas;
+
+  //! Arenas of the batch being written; only used by the writer thread.
+  std::vector<google::protobuf::Arena*> usedArenas;
+
+  //! Lock for the arena pool.
+  std::mutex arenaMutex;
 };
 
+//! The default filewriter, holding the events in a SharedQueue.
+typedef FileWriterType<> FileWriter;
+
 } // namespace mlboard
 
 // Include implementation.
@@ -7,125 +7,312 @@
 
 #include "filewriter.hpp"
 
-#ifdef _WIN32
-  #include <io.h>
-  #include <direct.h>
-#endif
-
 namespace mlboard {
 
 
-inline FileWriter::FileWriter(std::string logdir,
-                              int maxQueueSize,
-                              std::size_t flushmilis)
+template<typename QueueType>
+FileWriterType<QueueType>::FileWriterType(std::string logdir,
+                                          int maxQueueSize,
+                                          std::size_t flushmilis,
+                                          std::size_t flushBytes,
+                                          std::size_t flushIntervalMilis) :
+    q(maxQueueSize)
 {
-  const auto p1 = std::chrono::system_clock::now();
-  std::string currentTime =
-      std::to_string(std::chrono::duration_cast<std::chrono::seconds>(
-      p1.time_since_epoch()).count());
+  // Every filewriter gets its own file, even if many are created at the same
+  // time by many processes on many hosts.
   this->logdir = logdir;
-  this->filename = this->logdir + "/events.out.tfevents." + currentTime + ".v2";
+  this->filename = this->logdir + "/events.out.tfevents." +
+      util::UniqueName() + ".v2";
+  baseFilename = filename;
+  files.push_back(filename);
+  fileIndex = 0;
+  maxFileBytes = 0;
+  rotateMilis = 0;
+  maxFiles = 0;
   close_ = true;
   this->flushmilis = flushmilis;
-  size_t &maxSize = this->q.MaxSize();
-  maxSize = maxQueueSize;
-  thread_ = new std::thread(&FileWriter::WriteSummary, this);
-  nexttime =
-      std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+  this->flushBytes = flushBytes;
+  this->flushIntervalMilis = flushIntervalMilis;
   outfile.open(this->filename, std::fstream::out |
       std::ios::trunc | std::ios::binary);
+  thread_ = new std::thread(&FileWriterType::WriteSummary, this);
 }
 
-inline void FileWriter::WriteSummary()
+template<typename QueueType>
+void FileWriterType<QueueType>::WriteSummary()
 {
-  // This is a thread that will continously write summary one by one into file.
+  // This is a thread that will write the queued summaries into the file. It
+  // sleeps on the queue until there is something to write, so it doesn't use
+  // any CPU while the queue is idle.
+  std::chrono::steady_clock::time_point nexttime =
+      std::chrono::steady_clock::now();
+  std::chrono::steady_clock::time_point lastFlush = nexttime;
+  std::chrono::steady_clock::time_point lastWrite = nexttime;
+  std::chrono::steady_clock::time_point fileStart = nexttime;
+  size_t unflushedBytes = 0;
+  size_t fileBytes = 0;
+  std::string data;
+  std::queue<RecordType> records;
   while (true)
   {
+    // While written events wait for a flush, the thread also wakes up when
+    // the flush is due, even if nothing else is logged: after the flush
+    // interval, or, with only a byte count, after flushmilis without events.
+    bool idle = false;
+    if (unflushedBytes > 0)
+    {
+      const std::chrono::steady_clock::time_point flushDue =
+          flushIntervalMilis > 0 ?
+          lastFlush + std::chrono::milliseconds(flushIntervalMilis) :
+          lastWrite + std::chrono::milliseconds(flushmilis);
+      idle = !q.Wait(nexttime, flushDue);
+    }
+    else
+    {
+      q.Wait(nexttime);
+    }
+
+    // Take the whole batch out of the queue at once, and encode it into one
+    // buffer without holding the queue, so that it takes a single write to
+    // put it in the file.
+    q.PopAll(records);
+    while (!records.empty())
+    {
+      AppendRecord(records.front(), data, buffer);
+      records.pop();
+    }
+    if (!buffer.empty())
+    {
+      outfile.write(buffer.data(), buffer.size());
+      unflushedBytes += buffer.size();
+      fileBytes += buffer.size();
+      // Keep the capacity for the next batch.
+      buffer.clear();
+      lastWrite = std::chrono::steady_clock::now();
+    }
+    ReleaseArenas();
+
+    // Flush after every batch, unless a byte count or an interval was set.
+    const bool done = q.Closed() && q.Size() == 0;
+    const auto timenow = std::chrono::steady_clock::now();
+    const bool flushNow = idle ||
+        (flushBytes == 0 && flushIntervalMilis == 0) ||
+        (flushBytes > 0 && unflushedBytes >= flushBytes) ||
+        (flushIntervalMilis > 0 && timenow - lastFlush >=
+        std::chrono::milliseconds(flushIntervalMilis));
+    if (unflushedBytes > 0 && (done || flushNow))
+    {
+      outfile.flush();
+      unflushedBytes = 0;
+      lastFlush = timenow;
+    }
+
     // Break the loop if eveything is done.
-    if (!(close_ || q.Size() != 0)) break;
-    std::time_t timenow =
-        std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-    if (timenow >= nexttime)
+    if (done) break;
+
+    // Start a new file once the current one is big or old enough. A batch is
+    // never split across two files.
+    if (fileBytes > 0 && ((maxFileBytes > 0 && fileBytes >= maxFileBytes) ||
+        (rotateMilis > 0 && timenow - fileStart >=
+        std::chrono::milliseconds(rotateMilis))))
     {
-      while (q.Size() > 0)
-      {
-        mlboard::Event event = q.Pop();
-        std::string buf;
-        event.SerializeToString(&buf);
-        auto buf_len = static_cast<uint64_t>(buf.size());
-        uint32_t len_crc =
-            masked_crc32c((char *)&buf_len, sizeof(uint64_t));
-        uint32_t data_crc = masked_crc32c(buf.c_str(), buf.size());
-
-        outfile.write((char *)&buf_len, sizeof(uint64_t));
-        outfile.write((char *)&len_crc, sizeof(uint32_t));
-        outfile.write(buf.c_str(), buf.size());
-        outfile.write((char *)&data_crc, sizeof(uint32_t));
-        outfile.flush();
-      }
-      nexttime =
-          std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()
-          + std::chrono::milliseconds(flushmilis));
+      RotateFile();
+      unflushedBytes = 0;
+      fileBytes = 0;
+      fileStart = timenow;
     }
+
+    nexttime = timenow + std::chrono::milliseconds(flushmilis);
   }
 }
 
-inline void FileWriter::CreateEvent(size_t step, mlboard::Summary *summary)
+template<typename QueueType>
+void FileWriterType<QueueType>::EncodeRecord(const std::string& data,
+                                             std::string& buffer)
+{
+  const uint64_t len = static_cast<uint64_t>(data.size());
+  const uint32_t lenCrc = masked_crc32c((const char *)&len, sizeof(uint64_t));
+  const uint32_t dataCrc = masked_crc32c(data.data(), data.size());
+
+  buffer.append((const char *)&len, sizeof(uint64_t));
+  buffer.append((const char *)&lenCrc, sizeof(uint32_t));
+  buffer.append(data);
+  buffer.append((const char *)&dataCrc, sizeof(uint32_t));
+}
+
+template<typename QueueType>
+mlboard::Summary* FileWriterType<QueueType>::NewSummary()
+{
+  if (!useArena)
+    return new Summary();
+
+  google::protobuf::Arena* arena = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(arenaMutex);
+    if (!freeArenas.empty())
+    {
+      arena = freeArenas.back();
+      freeArenas.pop_back();
+    }
+    else
+    {
+      const size_t blockSize = 4096;
+      arenaBlocks.emplace_back(new char[blockSize]);
+      google::protobuf::ArenaOptions options;
+      options.initial_block = arenaBlocks.back().get();
+      options.initial_block_size = blockSize;
+      arenas.emplace_back(new google::protobuf::Arena(options));
+      arena = arenas.back().get();
+    }
+  }
+
+  // An arena hands its initial block to the thread that resets it, so the
+  // arena is reset by the thread that is going to use it.
+  arena->Reset();
+  return google::protobuf::Arena::CreateMessage<Summary>(arena);
+}
+
+template<typename QueueType>
+void FileWriterType<QueueType>::CreateEvent(size_t step,
+                                            mlboard::Summary *summary)
+{
+  RecordType record;
+  MakeRecord(step, summary, record);
+  q.Push(std::move(record));
+}
+
+template<typename QueueType>
+void FileWriterType<QueueType>::FillEvent(size_t step,
+                                          mlboard::Summary* summary,
+                                          mlboard::Event& event)
 {
-  Event event;
   double wall_time = time(nullptr);
   event.set_wall_time(wall_time);
   event.set_step(step);
   event.set_allocated_summary(summary);
-  q.Push(event);
 }
 
-inline void FileWriter::Flush()
+template<typename QueueType>
+void FileWriterType<QueueType>::MakeRecord(size_t step,
+                                           mlboard::Summary* summary,
+                                           mlboard::Event& record)
 {
-  // Flush everything successfully and close the thread.
-  thread_->join();
+  FillEvent(step, summary, record);
 }
 
-inline void FileWriter::Close()
+template<typename QueueType>
+void FileWriterType<QueueType>::MakeRecord(size_t step,
+                                           mlboard::Summary* summary,
+                                           std::string& record)
 {
-  close_ = false;
-  Flush();
+  // Serialize and checksum on the calling thread.
+  Event event;
+  FillEvent(step, summary, event);
+  std::string data;
+  event.SerializeToString(&data);
+  EncodeRecord(data, record);
 }
 
-inline FileWriter::~FileWriter()
+template<typename QueueType>
+void FileWriterType<QueueType>::MakeRecord(size_t step,
+                                           mlboard::Summary* summary,
+                                           mlboard::Event*& record)
 {
-  if (close_)
-    Close();
+  // The event lives on the same arena as the summary, so it takes the
+  // summary without copying it.
+  record = google::protobuf::Arena::CreateMessage<Event>(summary->GetArena());
+  FillEvent(step, summary, *record);
+}
 
-  std::regex regExp("(_preprocess)(.*)");
+template<typename QueueType>
+void FileWriterType<QueueType>::AppendRecord(const mlboard::Event& record,
+                                             std::string& data,
+                                             std::string& buffer)
+{
+  record.SerializeToString(&data);
+  EncodeRecord(data, buffer);
+}
 
-  // Delete all the directories created during processing.
-  struct dirent *entry;
-  DIR *dir = opendir("./");
+template<typename QueueType>
+void FileWriterType<QueueType>::AppendRecord(const std::string& record,
+                                             std::string& /* data */,
+                                             std::string& buffer)
+{
+  buffer.append(record);
+}
 
-  if (dir == NULL)
-  {
+template<typename QueueType>
+void FileWriterType<QueueType>::AppendRecord(mlboard::Event* record,
+                                             std::string& data,
+                                             std::string& buffer)
+{
+  AppendRecord(*record, data, buffer);
+
+  // Events of summaries that weren't created by NewSummary() are on the heap.
+  if (record->GetArena() == nullptr)
+    delete record;
+  else
+    usedArenas.push_back(record->GetArena());
+}
+
+template<typename QueueType>
+void FileWriterType<QueueType>::ReleaseArenas()
+{
+  if (usedArenas.empty())
     return;
-  }
-  while ((entry = readdir(dir)) != NULL)
+
+  // Nothing else refers to the arenas of the batch anymore; they are reset
+  // when they are used again.
+  std::lock_guard<std::mutex> lock(arenaMutex);
+  freeArenas.insert(freeArenas.end(), usedArenas.begin(), usedArenas.end());
+  usedArenas.clear();
+}
+
+template<typename QueueType>
+void FileWriterType<QueueType>::RotateFile()
+{
+  outfile.close();
+
+  // The counter is zero padded so that the files sort in the order they were
+  // written.
+  ++fileIndex;
+  std::string index = std::to_string(fileIndex);
+  if (index.size() < 6)
+    index.insert(0, 6 - index.size(), '0');
+
+  std::lock_guard<std::mutex> lock(fileMutex);
+  filename = baseFilename + "." + index;
+  files.push_back(filename);
+  while (maxFiles > 0 && files.size() > maxFiles)
   {
-    if (entry->d_name != "." && entry->d_name != ".."
-      && std::regex_match(entry->d_name, regExp) == true)
-    {
-      int status;
-      #if defined(_WIN32)
-        status = _rmdir(entry->d_name);
-      #else
-        status = rmdir(entry->d_name);
-      #endif
-      if (status == -1)
-      {
-        std::cout << "Error while removing temp directory: " << entry->d_name
-            << std::endl;
-      }
-    }
+    remove(files.front().c_str());
+    files.pop_front();
   }
-  closedir(dir);
+
+  outfile.open(filename, std::fstream::out |
+      std::ios::trunc | std::ios::binary);
+}
+
+template<typename QueueType>
+void FileWriterType<QueueType>::Flush()
+{
+  // Flush everything successfully and close the thread.
+  thread_->join();
+}
+
+template<typename QueueType>
+void FileWriterType<QueueType>::Close()
+{
+  close_ = false;
+  q.Close();
+  Flush();
+}
+
+template<typename QueueType>
+FileWriterType<QueueType>::~FileWriterType()
+{
+  if (close_)
+    Close();
 }
 
 } // namespace mlboard
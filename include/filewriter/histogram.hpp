@@ -0,0 +1,264 @@
+/**
+ * @file filewriter/histogram.hpp
+ *
+ * Kernels that compute the statistics and the bucket counts of a histogram.
+ */
+#ifndef MLBOARD_HISTOGRAM_HPP
+#define MLBOARD_HISTOGRAM_HPP
+
+#include <mlboard/core.hpp>
+#include "util.hpp"
+
+#if (defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))) || \
+    defined(_M_X64)
+  #define MLBOARD_HISTOGRAM_AVX
+#endif
+
+namespace mlboard {
+namespace util {
+
+/**
+ * Class holding the statistics of the values of a histogram: the number of
+ * values, their minimum, maximum, sum and sum of squares, and the number of
+ * values in every bucket. Everything is accumulated in double precision.
+ */
+class HistogramStats
+{
+ public:
+  /**
+   * Create the statistics of an empty histogram.
+   *
+   * @param buckets Number of buckets, the same as the number of edges.
+   */
+  HistogramStats(const size_t buckets = 0);
+
+  /**
+   * Add the statistics of other values, with the same buckets.
+   *
+   * @param other Statistics to add.
+   */
+  void Merge(const HistogramStats& other);
+
+  //! Get the number of values.
+  size_t Num() const { return num; }
+  //! Modify the number of values.
+  size_t& Num() { return num; }
+  //! Get the smallest value.
+  double Min() const { return min; }
+  //! Modify the smallest value.
+  double& Min() { return min; }
+  //! Get the largest value.
+  double Max() const { return max; }
+  //! Modify the largest value.
+  double& Max() { return max; }
+  //! Get the sum of the values.
+  double Sum() const { return sum; }
+  //! Modify the sum of the values.
+  double& Sum() { return sum; }
+  //! Get the sum of the squares of the values.
+  double SumSquares() const { return sumSquares; }
+  //! Modify the sum of the squares of the values.
+  double& SumSquares() { return sumSquares; }
+  //! Get the number of values in every bucket.
+  const std::vector<size_t>& Counts() const { return counts; }
+  //! Modify the number of values in every bucket.
+  std::vector<size_t>& Counts() { return counts; }
+
+ private:
+  //! Number of values.
+  size_t num;
+
+  //! Smallest value.
+  double min;
+
+  //! Largest value.
+  double max;
+
+  //! Sum of the values.
+  double sum;
+
+  //! Sum of the squares of the values.
+  double sumSquares;
+
+  //! Number of values in every bucket.
+  std::vector<size_t> counts;
+};
+
+/**
+ * Function to add values to the statistics of a histogram. A value goes to
+ * the first edge that is not smaller than it, as in HistogramBucket(). The
+ * default edges are looked up in constant time. The kernel is picked on the
+ * first call: AVX-512 or AVX2 if the processor has them, scalar code
+ * otherwise. If mlboard is built with OpenMP and there are at least
+ * HistogramParallelSize() values, they are split among the threads, and the
+ * statistics of every thread are merged afterwards.
+ *
+ * @tparam eT Arithmetic type of the values. Values other than double are
+ *     converted to double in small blocks, without copying all of them.
+ * @param values Pointer to the values.
+ * @param n Number of values.
+ * @param edges Sorted edges of the histogram.
+ * @param stats Statistics the values are added to; they have one bucket for
+ *     every edge.
+ */
+template<typename eT>
+void HistogramUpdate(const eT* values,
+                     const size_t n,
+                     const std::vector<double>& edges,
+                     HistogramStats& stats);
+
+/**
+ * Function to get and modify the number of values from which
+ * HistogramUpdate() runs in parallel (1 << 18 by default). Smaller inputs
+ * take less time than starting the threads.
+ */
+size_t& HistogramParallelSize();
+
+/**
+ * Kernel of HistogramUpdate() on a single thread, picked on the first call.
+ */
+void HistogramKernel(const double* values,
+                     const size_t n,
+                     const std::vector<double>& edges,
+                     HistogramStats& stats);
+
+/**
+ * Kernel of HistogramUpdate() on a single thread for values other than
+ * double, which are converted in blocks.
+ */
+template<typename eT>
+void HistogramKernel(const eT* values,
+                     const size_t n,
+                     const std::vector<double>& edges,
+                     HistogramStats& stats);
+
+/**
+ * Scalar kernel of HistogramUpdate().
+ */
+void HistogramUpdateScalar(const double* values,
+                           const size_t n,
+                           const std::vector<double>& edges,
+                           HistogramStats& stats);
+
+#ifdef MLBOARD_HISTOGRAM_AVX
+/**
+ * AVX2 kernel of HistogramUpdate(); only call it if HistogramAVX2Supported().
+ */
+void HistogramUpdateAVX2(const double* values,
+                         const size_t n,
+                         const std::vector<double>& edges,
+                         HistogramStats& stats);
+
+/**
+ * AVX-512 kernel of HistogramUpdate(); only call it if
+ * HistogramAVX512Supported().
+ */
+void HistogramUpdateAVX512(const double* values,
+                           const size_t n,
+                           const std::vector<double>& edges,
+                           HistogramStats& stats);
+
+//! Whether the processor and the operating system support AVX2.
+bool HistogramAVX2Supported();
+
+//! Whether the processor and the operating system support AVX-512.
+bool HistogramAVX512Supported();
+#endif
+
+} // namespace util
+
+/**
+ * Class to build a histogram from values that arrive in many batches, such
+ * as the activations seen during an epoch. Only the statistics are kept, so
+ * the memory doesn't grow with the number of values. The histogram is
+ * logged with SummaryWriter::Histogram(), and the accumulator can be reset
+ * for the next epoch. An accumulator isn't shared between threads; give
+ * every thread its own and Merge() them.
+ */
+class HistogramAccumulator
+{
+ public:
+  /**
+   * Create an accumulator with the default bins.
+   */
+  HistogramAccumulator();
+
+  /**
+   * Create an accumulator with the given bins.
+   *
+   * @param bins The edges of the histogram.
+   */
+  HistogramAccumulator(const std::vector<double>& bins);
+
+  /**
+   * Add values in memory.
+   *
+   * @tparam eT Arithmetic type of the values.
+   * @param values Pointer to the values.
+   * @param n Number of values.
+   */
+  template<typename eT>
+  void Add(const eT* values, const size_t n);
+
+  /**
+   * Add the values of a vector.
+   *
+   * @param values Values to add.
+   */
+  template<typename eT>
+  void Add(const std::vector<eT>& values);
+
+  /**
+   * Add the values of an Armadillo matrix or vector, such as arma::mat or
+   * arma::frowvec.
+   *
+   * @param values Values to add.
+   */
+  template<typename MatType>
+  void Add(const MatType& values);
+
+  /**
+   * Add the values of an Armadillo subview.
+   *
+   * @param values Values to add.
+   */
+  template<typename eT>
+  void Add(const arma::subview<eT>& values);
+
+  /**
+   * Add the values of another accumulator with the same bins.
+   *
+   * @param other Accumulator to add.
+   */
+  void Merge(const HistogramAccumulator& other);
+
+  /**
+   * Forget all the values, keeping the bins.
+   */
+  void Reset();
+
+  //! Get the statistics of the values added so far.
+  const util::HistogramStats& Stats() const { return stats; }
+  //! Get the edges of the histogram.
+  const std::vector<double>& Bins() const
+  {
+    return defaultBins ? util::DefaultHistogramEdges() : bins;
+  }
+
+ private:
+  //! Whether the default bins are used; they aren't copied.
+  bool defaultBins;
+
+  //! The edges of the histogram, if they aren't the default ones.
+  std::vector<double> bins;
+
+  //! Statistics of the values added so far.
+  util::HistogramStats stats;
+};
+
+} // namespace mlboard
+
+// Include implementation.
+#include "histogram_impl.hpp"
+
+#endif
@@ -0,0 +1,497 @@
+/**
+ * @file filewriter/histogram_impl.hpp
+ *
+ * Implementation of the histogram kernels.
+ */
+#ifndef MLBOARD_HISTOGRAM_IMPL_HPP
+#define MLBOARD_HISTOGRAM_IMPL_HPP
+
+#include "histogram.hpp"
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+#ifdef MLBOARD_HISTOGRAM_AVX
+  #include <immintrin.h>
+  #if defined(_MSC_VER)
+    #include <intrin.h>
+    #define MLBOARD_TARGET_AVX2
+    #define MLBOARD_TARGET_AVX512
+  #else
+    #define MLBOARD_TARGET_AVX2 __attribute__((target("avx2")))
+    #define MLBOARD_TARGET_AVX512 __attribute__((target("avx512f")))
+  #endif
+#endif
+
+namespace mlboard {
+namespace util {
+
+inline HistogramStats::HistogramStats(const size_t buckets) :
+    num(0),
+    min(std::numeric_limits<double>::max()),
+    max(std::numeric_limits<double>::lowest()),
+    sum(0.0),
+    sumSquares(0.0),
+    counts(buckets, 0)
+{
+  // Nothing to do here.
+}
+
+inline void HistogramStats::Merge(const HistogramStats& other)
+{
+  num += other.num;
+  min = (std::min)(min, other.min);
+  max = (std::max)(max, other.max);
+  sum += other.sum;
+  sumSquares += other.sumSquares;
+  for (size_t i = 0; i < counts.size(); ++i)
+    counts[i] += other.counts[i];
+}
+
+inline size_t& HistogramParallelSize()
+{
+  static size_t size = 1 << 18;
+  return size;
+}
+
+inline void HistogramUpdateScalar(const double* values,
+                                  const size_t n,
+                                  const std::vector<double>& edges,
+                                  HistogramStats& stats)
+{
+  const bool defaultEdges = (&edges == &DefaultHistogramEdges());
+  std::vector<size_t>& counts = stats.Counts();
+  double min = stats.Min();
+  double max = stats.Max();
+  double sum = 0.0;
+  double sumSquares = 0.0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    const double v = values[i];
+    counts[defaultEdges ? DefaultHistogramBucket(v) :
+        HistogramBucket(edges, v)]++;
+    sum += v;
+    sumSquares += v * v;
+    if (v < min)
+      min = v;
+    if (v > max)
+      max = v;
+  }
+
+  stats.Num() += n;
+  stats.Min() = min;
+  stats.Max() = max;
+  stats.Sum() += sum;
+  stats.SumSquares() += sumSquares;
+}
+
+#ifdef MLBOARD_HISTOGRAM_AVX
+
+// The vector kernels work on blocks of values: they compute the moments and
+// the buckets of the default edges with vector instructions, store the
+// buckets of the block, and count them afterwards. Other edges are counted
+// with a binary search after the moments. The bucket of a value is
+// looked up as in DefaultHistogramBucket(), whose guess is never more than
+// one bucket off, so a single correction in each direction is enough. The
+// values after the last full vector are left to the scalar kernel.
+
+MLBOARD_TARGET_AVX2
+inline void HistogramUpdateAVX2(const double* values,
+                                const size_t n,
+                                const std::vector<double>& edges,
+                                HistogramStats& stats)
+{
+  const size_t blockSize = 256;
+  const bool defaultEdges = (&edges == &DefaultHistogramEdges());
+  const DefaultHistogramLookup& lookup = DefaultHistogramLookup::Get();
+  const int* guess = reinterpret_cast<const int*>(lookup.Guess());
+  const double* edge = edges.data();
+  size_t* counts = stats.Counts().data();
+
+  const __m256i absMask = _mm256_set1_epi64x(0x7fffffffffffffffLL);
+  const __m256i keyMin = _mm256_set1_epi64x(lookup.KeyMin());
+  const __m256i keyRange = _mm256_set1_epi64x(lookup.KeyMax() -
+      lookup.KeyMin());
+  const __m256i half = _mm256_set1_epi64x(lookup.Half());
+  const __m256i last = _mm256_set1_epi64x(edges.size() - 1);
+  const __m256i one = _mm256_set1_epi64x(1);
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256d zeroPd = _mm256_setzero_pd();
+
+  __m256d min = _mm256_set1_pd(stats.Min());
+  __m256d max = _mm256_set1_pd(stats.Max());
+  __m256d sum = _mm256_setzero_pd();
+  __m256d sumSquares = _mm256_setzero_pd();
+
+  alignas(32) uint64_t bucket[blockSize];
+  const size_t vectorEnd = n - n % 4;
+  for (size_t start = 0; start < vectorEnd; start += blockSize)
+  {
+    const size_t end = (std::min)(start + blockSize, vectorEnd);
+    for (size_t i = start; i < end; i += 4)
+    {
+      const __m256d v = _mm256_loadu_pd(values + i);
+
+      // The value goes second, so that NaN doesn't replace the minimum or
+      // the maximum.
+      min = _mm256_min_pd(v, min);
+      max = _mm256_max_pd(v, max);
+      sum = _mm256_add_pd(sum, v);
+      sumSquares = _mm256_add_pd(sumSquares, _mm256_mul_pd(v, v));
+
+      if (!defaultEdges)
+        continue;
+
+      // Guess the bucket of the magnitude among the positive edges.
+      __m256i key = _mm256_sub_epi64(_mm256_srli_epi64(_mm256_and_si256(
+          _mm256_castpd_si256(v), absMask), DefaultHistogramLookup::keyShift),
+          keyMin);
+      key = _mm256_blendv_epi8(key, zero, _mm256_cmpgt_epi64(zero, key));
+      key = _mm256_blendv_epi8(key, keyRange,
+          _mm256_cmpgt_epi64(key, keyRange));
+      const __m256i positive = _mm256_cvtepi32_epi64(
+          _mm256_i64gather_epi32(guess, key, 4));
+
+      // The negative edges mirror the positive ones.
+      const __m256d negative = _mm256_cmp_pd(v, zeroPd, _CMP_LT_OQ);
+      __m256i b = _mm256_blendv_epi8(_mm256_add_epi64(half, positive),
+          _mm256_sub_epi64(half, positive), _mm256_castpd_si256(negative));
+
+      // Correct the guess; the masks are -1 where they hold.
+      const __m256i up = _mm256_and_si256(_mm256_castpd_si256(_mm256_cmp_pd(
+          _mm256_i64gather_pd(edge, b, 8), v, _CMP_LT_OQ)),
+          _mm256_cmpgt_epi64(last, b));
+      b = _mm256_sub_epi64(b, up);
+      const __m256i above = _mm256_cmpgt_epi64(b, zero);
+      const __m256i previous = _mm256_and_si256(_mm256_sub_epi64(b, one),
+          above);
+      const __m256i down = _mm256_and_si256(_mm256_castpd_si256(_mm256_cmp_pd(
+          _mm256_i64gather_pd(edge, previous, 8), v, _CMP_GE_OQ)), above);
+      b = _mm256_add_epi64(b, down);
+
+      // A binary search on NaN stops at the first bucket.
+      b = _mm256_andnot_si256(_mm256_castpd_si256(_mm256_cmp_pd(v, v,
+          _CMP_UNORD_Q)), b);
+      _mm256_store_si256(reinterpret_cast<__m256i*>(bucket + i - start), b);
+    }
+
+    if (defaultEdges)
+    {
+      for (size_t i = start; i < end; ++i)
+        counts[bucket[i - start]]++;
+    }
+  }
+
+  alignas(32) double lanes[4][4];
+  _mm256_store_pd(lanes[0], min);
+  _mm256_store_pd(lanes[1], max);
+  _mm256_store_pd(lanes[2], sum);
+  _mm256_store_pd(lanes[3], sumSquares);
+  for (size_t i = 0; i < 4; ++i)
+  {
+    stats.Min() = (std::min)(stats.Min(), lanes[0][i]);
+    stats.Max() = (std::max)(stats.Max(), lanes[1][i]);
+  }
+  stats.Sum() += (lanes[2][0] + lanes[2][1]) + (lanes[2][2] + lanes[2][3]);
+  stats.SumSquares() += (lanes[3][0] + lanes[3][1]) +
+      (lanes[3][2] + lanes[3][3]);
+  stats.Num() += vectorEnd;
+
+  // The binary search and the scalar kernel aren't vector code; leave the
+  // vector state first, or every instruction pays for the transition.
+  _mm256_zeroupper();
+  if (!defaultEdges)
+  {
+    for (size_t i = 0; i < vectorEnd; ++i)
+      counts[HistogramBucket(edges, values[i])]++;
+  }
+
+  HistogramUpdateScalar(values + vectorEnd, n - vectorEnd, edges, stats);
+}
+
+// Some versions of GCC warn about the undefined registers that the AVX-512
+// intrinsics start from.
+#if defined(__GNUC__) && !defined(__clang__)
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+MLBOARD_TARGET_AVX512
+inline void HistogramUpdateAVX512(const double* values,
+                                  const size_t n,
+                                  const std::vector<double>& edges,
+                                  HistogramStats& stats)
+{
+  const size_t blockSize = 256;
+  const bool defaultEdges = (&edges == &DefaultHistogramEdges());
+  const DefaultHistogramLookup& lookup = DefaultHistogramLookup::Get();
+  const uint32_t* guess = lookup.Guess();
+  const double* edge = edges.data();
+  size_t* counts = stats.Counts().data();
+
+  const __m512i absMask = _mm512_set1_epi64(0x7fffffffffffffffLL);
+  const __m512i keyMin = _mm512_set1_epi64(lookup.KeyMin());
+  const __m512i keyMax = _mm512_set1_epi64(lookup.KeyMax());
+  const __m512i half = _mm512_set1_epi64(lookup.Half());
+  const __m512i last = _mm512_set1_epi64(edges.size() - 1);
+  const __m512i one = _mm512_set1_epi64(1);
+  const __m512i zero = _mm512_setzero_si512();
+  const __m512d zeroPd = _mm512_setzero_pd();
+
+  __m512d min = _mm512_set1_pd(stats.Min());
+  __m512d max = _mm512_set1_pd(stats.Max());
+  __m512d sum = _mm512_setzero_pd();
+  __m512d sumSquares = _mm512_setzero_pd();
+
+  alignas(64) uint64_t bucket[blockSize];
+  const size_t vectorEnd = n - n % 8;
+  for (size_t start = 0; start < vectorEnd; start += blockSize)
+  {
+    const size_t end = (std::min)(start + blockSize, vectorEnd);
+    for (size_t i = start; i < end; i += 8)
+    {
+      const __m512d v = _mm512_loadu_pd(values + i);
+
+      // The value goes second, so that NaN doesn't replace the minimum or
+      // the maximum.
+      min = _mm512_min_pd(v, min);
+      max = _mm512_max_pd(v, max);
+      sum = _mm512_add_pd(sum, v);
+      sumSquares = _mm512_add_pd(sumSquares, _mm512_mul_pd(v, v));
+
+      if (!defaultEdges)
+        continue;
+
+      // Guess the bucket of the magnitude among the positive edges.
+      __m512i key = _mm512_srli_epi64(_mm512_and_epi64(
+          _mm512_castpd_si512(v), absMask), DefaultHistogramLookup::keyShift);
+      key = _mm512_sub_epi64(_mm512_min_epi64(_mm512_max_epi64(key, keyMin),
+          keyMax), keyMin);
+      const __m512i positive = _mm512_cvtepi32_epi64(
+          _mm512_i64gather_epi32(key, guess, 4));
+
+      // The negative edges mirror the positive ones.
+      const __mmask8 negative = _mm512_cmp_pd_mask(v, zeroPd, _CMP_LT_OQ);
+      __m512i b = _mm512_mask_sub_epi64(_mm512_add_epi64(half, positive),
+          negative, half, positive);
+
+      // Correct the guess.
+      const __mmask8 up = _mm512_cmp_pd_mask(_mm512_i64gather_pd(b, edge, 8),
+          v, _CMP_LT_OQ) & _mm512_cmplt_epi64_mask(b, last);
+      b = _mm512_mask_add_epi64(b, up, b, one);
+      const __mmask8 above = _mm512_cmpgt_epi64_mask(b, zero);
+      const __m512d previous = _mm512_mask_i64gather_pd(zeroPd, above,
+          _mm512_sub_epi64(b, one), edge, 8);
+      const __mmask8 down = _mm512_cmp_pd_mask(previous, v, _CMP_GE_OQ) &
+          above;
+      b = _mm512_mask_sub_epi64(b, down, b, one);
+
+      // A binary search on NaN stops at the first bucket.
+      b = _mm512_maskz_mov_epi64(_mm512_cmp_pd_mask(v, v, _CMP_ORD_Q), b);
+      _mm512_store_si512(bucket + i - start, b);
+    }
+
+    if (defaultEdges)
+    {
+      for (size_t i = start; i < end; ++i)
+        counts[bucket[i - start]]++;
+    }
+  }
+
+  alignas(64) double lanes[4][8];
+  _mm512_store_pd(lanes[0], min);
+  _mm512_store_pd(lanes[1], max);
+  _mm512_store_pd(lanes[2], sum);
+  _mm512_store_pd(lanes[3], sumSquares);
+  double laneSum = 0.0;
+  double laneSumSquares = 0.0;
+  for (size_t i = 0; i < 8; ++i)
+  {
+    stats.Min() = (std::min)(stats.Min(), lanes[0][i]);
+    stats.Max() = (std::max)(stats.Max(), lanes[1][i]);
+    laneSum += lanes[2][i];
+    laneSumSquares += lanes[3][i];
+  }
+  stats.Sum() += laneSum;
+  stats.SumSquares() += laneSumSquares;
+  stats.Num() += vectorEnd;
+
+  // The binary search and the scalar kernel aren't vector code; leave the
+  // vector state first, or every instruction pays for the transition.
+  _mm256_zeroupper();
+  if (!defaultEdges)
+  {
+    for (size_t i = 0; i < vectorEnd; ++i)
+      counts[HistogramBucket(edges, values[i])]++;
+  }
+
+  HistogramUpdateScalar(values + vectorEnd, n - vectorEnd, edges, stats);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+  #pragma GCC diagnostic pop
+#endif
+
+inline bool HistogramAVX2Supported()
+{
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 1);
+  // The operating system has to save the AVX registers.
+  if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 0x6) != 0x6)
+    return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+
+inline bool HistogramAVX512Supported()
+{
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 1);
+  // The operating system has to save the AVX-512 registers.
+  if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 0xe6) != 0xe6)
+    return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 16)) != 0;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx512f");
+#endif
+}
+
+#endif // MLBOARD_HISTOGRAM_AVX
+
+inline void HistogramKernel(const double* values,
+                            const size_t n,
+                            const std::vector<double>& edges,
+                            HistogramStats& stats)
+{
+  typedef void (*HistogramUpdateFunc)(const double*, const size_t,
+      const std::vector<double>&, HistogramStats&);
+#ifdef MLBOARD_HISTOGRAM_AVX
+  static const HistogramUpdateFunc func =
+      HistogramAVX512Supported() ? HistogramUpdateAVX512 :
+      HistogramAVX2Supported() ? HistogramUpdateAVX2 : HistogramUpdateScalar;
+#else
+  static const HistogramUpdateFunc func = HistogramUpdateScalar;
+#endif
+  func(values, n, edges, stats);
+}
+
+template<typename eT>
+void HistogramKernel(const eT* values,
+                     const size_t n,
+                     const std::vector<double>& edges,
+                     HistogramStats& stats)
+{
+  static_assert(std::is_arithmetic<eT>::value,
+      "The values of a histogram have to be arithmetic.");
+
+  // Convert the values in blocks that stay in the cache, instead of copying
+  // all of them at once.
+  const size_t blockSize = 1024;
+  double block[blockSize];
+  for (size_t start = 0; start < n; start += blockSize)
+  {
+    const size_t count = (std::min)(blockSize, n - start);
+    for (size_t i = 0; i < count; ++i)
+      block[i] = static_cast<double>(values[start + i]);
+    HistogramKernel(block, count, edges, stats);
+  }
+}
+
+template<typename eT>
+void HistogramUpdate(const eT* values,
+                     const size_t n,
+                     const std::vector<double>& edges,
+                     HistogramStats& stats)
+{
+#ifdef _OPENMP
+  const int threads = omp_get_max_threads();
+  if (n >= HistogramParallelSize() && threads > 1 && !omp_in_parallel())
+  {
+    // Every thread takes a contiguous part of the values and its own
+    // statistics, so the threads don't share anything until the merge.
+    std::vector<HistogramStats> partial(threads,
+        HistogramStats(edges.size()));
+    #pragma omp parallel num_threads(threads)
+    {
+      const size_t thread = omp_get_thread_num();
+      const size_t count = omp_get_num_threads();
+      const size_t begin = n * thread / count;
+      const size_t end = n * (thread + 1) / count;
+      HistogramKernel(values + begin, end - begin, edges, partial[thread]);
+    }
+
+    for (size_t i = 0; i < partial.size(); ++i)
+      stats.Merge(partial[i]);
+    return;
+  }
+#endif
+
+  HistogramKernel(values, n, edges, stats);
+}
+
+} // namespace util
+
+inline HistogramAccumulator::HistogramAccumulator() :
+    defaultBins(true),
+    stats(util::DefaultHistogramEdges().size())
+{
+  // Nothing to do here.
+}
+
+inline HistogramAccumulator::HistogramAccumulator(
+    const std::vector<double>& bins) :
+    defaultBins(&bins == &util::DefaultHistogramEdges()),
+    stats(bins.size())
+{
+  if (!defaultBins)
+    this->bins = bins;
+}
+
+template<typename eT>
+void HistogramAccumulator::Add(const eT* values, const size_t n)
+{
+  util::HistogramUpdate(values, n, Bins(), stats);
+}
+
+template<typename eT>
+void HistogramAccumulator::Add(const std::vector<eT>& values)
+{
+  Add(values.data(), values.size());
+}
+
+template<typename MatType>
+void HistogramAccumulator::Add(const MatType& values)
+{
+  Add(values.memptr(), values.n_elem);
+}
+
+template<typename eT>
+void HistogramAccumulator::Add(const arma::subview<eT>& values)
+{
+  // Every column of a subview is contiguous.
+  for (size_t i = 0; i < values.n_cols; ++i)
+    Add(values.colptr(i), values.n_rows);
+}
+
+inline void HistogramAccumulator::Merge(const HistogramAccumulator& other)
+{
+  stats.Merge(other.stats);
+}
+
+inline void HistogramAccumulator::Reset()
+{
+  stats = util::HistogramStats(Bins().size());
+}
+
+} // namespace mlboard
+
+#endif
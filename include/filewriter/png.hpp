@@ -0,0 +1,108 @@
+/**
+ * @file filewriter/png.hpp
+ *
+ * A small PNG encoder, to encode images in memory.
+ */
+#ifndef MLBOARD_PNG_HPP
+#define MLBOARD_PNG_HPP
+
+#include <mlboard/core.hpp>
+
+namespace mlboard {
+namespace util {
+
+/**
+ * Function to encode an image as a PNG in memory. The pixels are stored row
+ * by row, with the channels of every pixel next to each other, which is the
+ * layout of a column of an image matrix in mlpack. Every row gets the PNG
+ * filter that makes it the smallest, and the filtered rows are compressed
+ * with ZlibCompress(). It throws std::invalid_argument if the image is empty
+ * or doesn't have 1 (gray), 2 (gray and alpha), 3 (RGB) or 4 (RGBA)
+ * channels.
+ *
+ * @param pixels Pointer to the 8-bit pixels.
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param channels Number of channels of the image.
+ * @param encodedImage Output PNG.
+ */
+void EncodePNG(const unsigned char* pixels,
+               const size_t width,
+               const size_t height,
+               const size_t channels,
+               std::string& encodedImage);
+
+/**
+ * Function to quantize a pixel to 8 bits: the value is clamped to [0, 255]
+ * and rounded to the nearest integer, and NaN becomes 0. Integral values
+ * come out as mlpack::data::Save() writes them.
+ *
+ * @param value Value of the pixel.
+ * @return 8-bit pixel.
+ */
+unsigned char QuantizePixel(const double value);
+
+/**
+ * An overload to encode pixels of another type as a PNG. Every value is
+ * quantized to 8 bits with QuantizePixel().
+ *
+ * @tparam eT Arithmetic type of the pixels.
+ * @param pixels Pointer to the pixels.
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param channels Number of channels of the image.
+ * @param encodedImage Output PNG.
+ */
+template<typename eT>
+void EncodePNG(const eT* pixels,
+               const size_t width,
+               const size_t height,
+               const size_t channels,
+               std::string& encodedImage);
+
+/**
+ * An overload to encode every column of a matrix as a PNG, in the layout of
+ * mlpack's image matrices. If mlboard is built with OpenMP, the columns are
+ * encoded in parallel, and the images keep the order of the columns.
+ *
+ * @tparam eT Arithmetic type of the pixels.
+ * @param images Matrix with an image in every column.
+ * @param width Width of the images.
+ * @param height Height of the images.
+ * @param channels Number of channels of the images.
+ * @param encodedImages Output PNG of every column.
+ */
+template<typename eT>
+void EncodePNG(const arma::Mat<eT>& images,
+               const size_t width,
+               const size_t height,
+               const size_t channels,
+               std::vector<std::string>& encodedImages);
+
+/**
+ * Function to compress data into a zlib stream. The data is matched with
+ * LZ77 over hash chains, and written as a single deflate block with dynamic
+ * Huffman codes or with the fixed ones, or as stored blocks, whichever is
+ * the smallest.
+ *
+ * @param data Pointer to the data.
+ * @param n Number of bytes.
+ * @param compressed String the zlib stream is appended to.
+ */
+void ZlibCompress(const unsigned char* data,
+                  const size_t n,
+                  std::string& compressed);
+
+/**
+ * Function to compute the CRC-32 of PNG chunks (the ISO-HDLC polynomial; the
+ * one of crc32buf() is CRC-32C), chained from a previous CRC (0 to start).
+ */
+uint32_t PNGCrc32(uint32_t crc, const unsigned char* buf, const size_t len);
+
+} // namespace util
+} // namespace mlboard
+
+// Include implementation.
+#include "png_impl.hpp"
+
+#endif
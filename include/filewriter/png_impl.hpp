@@ -0,0 +1,688 @@
+/**
+ * @file filewriter/png_impl.hpp
+ *
+ * Implementation of the PNG encoder.
+ */
+#ifndef MLBOARD_PNG_IMPL_HPP
+#define MLBOARD_PNG_IMPL_HPP
+
+#include "png.hpp"
+
+namespace mlboard {
+namespace util {
+
+inline uint32_t PNGCrc32(uint32_t crc, const unsigned char* buf,
+                         const size_t len)
+{
+  struct Table
+  {
+    Table()
+    {
+      for (uint32_t i = 0; i < 256; ++i)
+      {
+        uint32_t c = i;
+        for (int k = 0; k < 8; ++k)
+          c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        entries[i] = c;
+      }
+    }
+
+    uint32_t entries[256];
+  };
+  static const Table table;
+
+  crc = ~crc;
+  for (size_t i = 0; i < len; ++i)
+    crc = table.entries[(crc ^ buf[i]) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
+
+/**
+ * Writer of the bits of a deflate stream, starting from the least
+ * significant bit of every byte.
+ */
+class DeflateBitWriter
+{
+ public:
+  DeflateBitWriter(std::string& out) : out(out), buffer(0), count(0) { }
+
+  //! Write the n lowest bits of the given bits; n is at most 24.
+  void Put(const uint32_t bits, const int n)
+  {
+    buffer |= static_cast<uint64_t>(bits) << count;
+    count += n;
+    while (count >= 8)
+    {
+      out.push_back(static_cast<char>(buffer & 0xFF));
+      buffer >>= 8;
+      count -= 8;
+    }
+  }
+
+  //! Write the remaining bits, padded to a byte.
+  void Flush()
+  {
+    if (count > 0)
+      out.push_back(static_cast<char>(buffer & 0xFF));
+    buffer = 0;
+    count = 0;
+  }
+
+ private:
+  //! Output stream.
+  std::string& out;
+
+  //! Bits that don't fill a byte yet.
+  uint64_t buffer;
+
+  //! Number of bits in the buffer.
+  int count;
+};
+
+/**
+ * Find the lengths of a Huffman code of the given symbol frequencies, with
+ * no code longer than maxBits. While the code is too long, the frequencies
+ * are halved, which flattens the tree. Symbols that don't occur get no code,
+ * but at least two symbols get one, so that the code is complete.
+ */
+inline void HuffmanCodeLengths(std::vector<size_t> frequencies,
+                               const int maxBits,
+                               std::vector<int>& lengths)
+{
+  const size_t symbols = frequencies.size();
+  size_t used = symbols - std::count(frequencies.begin(), frequencies.end(),
+      size_t(0));
+  for (size_t i = 0; i < symbols && used < 2; ++i)
+  {
+    if (frequencies[i] == 0)
+    {
+      frequencies[i] = 1;
+      ++used;
+    }
+  }
+
+  while (true)
+  {
+    // Build the tree from the two lightest nodes, until one is left.
+    typedef std::pair<size_t, size_t> Node;
+    std::priority_queue<Node, std::vector<Node>, std::greater<Node>> queue;
+    std::vector<size_t> parent(2 * symbols, 0);
+    for (size_t i = 0; i < symbols; ++i)
+    {
+      if (frequencies[i] > 0)
+        queue.push(Node(frequencies[i], i));
+    }
+    size_t next = symbols;
+    while (queue.size() > 1)
+    {
+      const Node first = queue.top();
+      queue.pop();
+      const Node second = queue.top();
+      queue.pop();
+      parent[first.second] = next;
+      parent[second.second] = next;
+      queue.push(Node(first.first + second.first, next++));
+    }
+
+    // The length of a code is the depth of its leaf; parents come after
+    // their children, and the root is the last node.
+    std::vector<int> depths(next, 0);
+    for (size_t i = next - 1; i-- > 0; )
+    {
+      if (i >= symbols || frequencies[i] > 0)
+        depths[i] = depths[parent[i]] + 1;
+    }
+
+    lengths.assign(symbols, 0);
+    int longest = 0;
+    for (size_t i = 0; i < symbols; ++i)
+    {
+      if (frequencies[i] > 0)
+        lengths[i] = depths[i];
+      longest = (std::max)(longest, lengths[i]);
+    }
+    if (longest <= maxBits)
+      return;
+
+    for (size_t i = 0; i < symbols; ++i)
+    {
+      if (frequencies[i] > 0)
+        frequencies[i] = (frequencies[i] >> 1) | 1;
+    }
+  }
+}
+
+/**
+ * Find the canonical Huffman codes of the given code lengths, with their bits
+ * reversed, so that they can be written with DeflateBitWriter::Put().
+ */
+inline void HuffmanCodes(const std::vector<int>& lengths,
+                         std::vector<uint32_t>& codes)
+{
+  int counts[16] = { 0 };
+  for (const int length : lengths)
+    ++counts[length];
+  counts[0] = 0;
+
+  uint32_t nextCodes[16] = { 0 };
+  uint32_t code = 0;
+  for (int bits = 1; bits < 16; ++bits)
+  {
+    code = (code + counts[bits - 1]) << 1;
+    nextCodes[bits] = code;
+  }
+
+  codes.assign(lengths.size(), 0);
+  for (size_t i = 0; i < lengths.size(); ++i)
+  {
+    if (lengths[i] == 0)
+      continue;
+    uint32_t c = nextCodes[lengths[i]]++, reversed = 0;
+    for (int bit = 0; bit < lengths[i]; ++bit, c >>= 1)
+      reversed = (reversed << 1) | (c & 1);
+    codes[i] = reversed;
+  }
+}
+
+inline void ZlibCompress(const unsigned char* data,
+                         const size_t n,
+                         std::string& compressed)
+{
+  static const int lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15,
+      17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227,
+      258 };
+  static const int lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1,
+      2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+  static const int distanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33,
+      49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097,
+      6145, 8193, 12289, 16385, 24577 };
+  static const int distanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4,
+      5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+  // The code of every match length, and of every distance: distances up to
+  // 256 are looked up directly, and longer ones by their bits above 7.
+  struct Codes
+  {
+    Codes()
+    {
+      for (int code = 0, length = 3; length <= 258; ++length)
+      {
+        while (code < 28 && lengthBase[code + 1] <= length)
+          ++code;
+        lengthCodes[length] = code;
+      }
+      for (int code = 0, distance = 1; distance <= 32768; ++distance)
+      {
+        while (code < 29 && distanceBase[code + 1] <= distance)
+          ++code;
+        if (distance <= 256)
+          distanceCodes[distance - 1] = code;
+        else if ((distance - 1) % 128 == 0)
+          distanceCodes[256 + ((distance - 1) >> 7)] = code;
+      }
+    }
+
+    int Distance(const int distance) const
+    {
+      return distance <= 256 ? distanceCodes[distance - 1] :
+          distanceCodes[256 + ((distance - 1) >> 7)];
+    }
+
+    unsigned char lengthCodes[259];
+    unsigned char distanceCodes[512];
+  };
+  static const Codes codes;
+
+  // The window of deflate, the number of earlier positions with the same
+  // hash that are tried, and the length of a match that is good enough.
+  const size_t window = 32768;
+  const int maxChain = 16;
+  const size_t maxLength = 258;
+  const size_t niceLength = 64;
+
+  // The most recent position of every hash, and the previous position with
+  // the same hash of every position in the window. Small inputs get small
+  // tables, since clearing them would cost more than compressing.
+  int hashBits = 8;
+  size_t ring = 256;
+  while (ring < (std::min)(n, window))
+  {
+    ring <<= 1;
+    hashBits += hashBits < 15;
+  }
+  std::vector<int64_t> head(size_t(1) << hashBits, -1);
+  std::vector<int64_t> previous(ring, -1);
+  auto hashAt = [data, hashBits](const size_t p)
+  {
+    return ((uint32_t(data[p]) << 16 | uint32_t(data[p + 1]) << 8 |
+        data[p + 2]) * 2654435761u) >> (32 - hashBits);
+  };
+
+  // First find the matches with LZ77; every token is a literal (length 0)
+  // or the length and distance of a match, with its symbols counted.
+  struct Token
+  {
+    uint16_t length;
+    uint16_t value;
+  };
+  std::vector<Token> tokens;
+  tokens.reserve(n / 2 + 1);
+  std::vector<size_t> literalFrequencies(286, 0), distanceFrequencies(30, 0);
+  size_t i = 0;
+  while (i + 3 <= n)
+  {
+    // Find the longest match among the most recent positions with the same
+    // hash. A candidate can only be longer if it matches at the end of the
+    // longest match so far, which is checked first.
+    size_t bestLength = 0, bestDistance = 0;
+    const size_t limit = (std::min)(maxLength, n - i);
+    const unsigned char* b = data + i;
+    int64_t candidate = head[hashAt(i)];
+    for (int chain = 0; chain < maxChain && candidate >= 0 &&
+        i - candidate <= window; ++chain)
+    {
+      const unsigned char* a = data + candidate;
+      if (a[bestLength] == b[bestLength] && a[0] == b[0])
+      {
+        size_t length = 0;
+        while (length < limit && a[length] == b[length])
+          ++length;
+        if (length > bestLength)
+        {
+          bestLength = length;
+          bestDistance = i - candidate;
+          if (length >= (std::min)(limit, niceLength))
+            break;
+        }
+      }
+
+      const int64_t next = previous[candidate & (ring - 1)];
+      if (next >= candidate)
+        break;
+      candidate = next;
+    }
+
+    size_t step = 1;
+    if (bestLength >= 3)
+    {
+      ++literalFrequencies[257 + codes.lengthCodes[bestLength]];
+      ++distanceFrequencies[codes.Distance(bestDistance)];
+      tokens.push_back({ (uint16_t) bestLength, (uint16_t) bestDistance });
+      step = bestLength;
+    }
+    else
+    {
+      ++literalFrequencies[data[i]];
+      tokens.push_back({ 0, data[i] });
+    }
+
+    // Every position that was passed is added to the hash chains.
+    for (const size_t end = i + step; i < end; ++i)
+    {
+      if (i + 3 > n)
+        continue;
+      const uint32_t hash = hashAt(i);
+      previous[i & (ring - 1)] = head[hash];
+      head[hash] = i;
+    }
+  }
+  for (; i < n; ++i)
+  {
+    ++literalFrequencies[data[i]];
+    tokens.push_back({ 0, data[i] });
+  }
+  ++literalFrequencies[256];
+
+  // The fixed codes of the literals and lengths, and of the distances.
+  std::vector<int> fixedLiteralLengths(288, 8), fixedDistanceLengths(30, 5);
+  std::fill(fixedLiteralLengths.begin() + 144,
+      fixedLiteralLengths.begin() + 256, 9);
+  std::fill(fixedLiteralLengths.begin() + 256,
+      fixedLiteralLengths.begin() + 280, 7);
+
+  // The dynamic codes, whose lengths are sent run-length encoded with the
+  // symbols 16 (repeat the previous length), 17 and 18 (repeat zero).
+  std::vector<int> literalLengths, distanceLengths;
+  HuffmanCodeLengths(literalFrequencies, 15, literalLengths);
+  HuffmanCodeLengths(distanceFrequencies, 15, distanceLengths);
+  size_t literalCount = 286, distanceCount = 30;
+  while (literalCount > 257 && literalLengths[literalCount - 1] == 0)
+    --literalCount;
+  while (distanceCount > 1 && distanceLengths[distanceCount - 1] == 0)
+    --distanceCount;
+  std::vector<int> allLengths(literalLengths.begin(),
+      literalLengths.begin() + literalCount);
+  allLengths.insert(allLengths.end(), distanceLengths.begin(),
+      distanceLengths.begin() + distanceCount);
+
+  std::vector<std::pair<int, int>> runs;
+  std::vector<size_t> lengthFrequencies(19, 0);
+  for (size_t j = 0; j < allLengths.size(); )
+  {
+    const int length = allLengths[j];
+    size_t run = 1;
+    while (j + run < allLengths.size() && allLengths[j + run] == length)
+      ++run;
+
+    if (length == 0 && run >= 3)
+    {
+      run = (std::min)(run, size_t(138));
+      runs.push_back(std::make_pair(run >= 11 ? 18 : 17, (int) run));
+    }
+    else if (length != 0 && run >= 4)
+    {
+      runs.push_back(std::make_pair(length, 0));
+      run = 1 + (std::min)(run - 1, size_t(6));
+      runs.push_back(std::make_pair(16, (int) run - 1));
+    }
+    else
+    {
+      run = 1;
+      runs.push_back(std::make_pair(length, 0));
+    }
+    ++lengthFrequencies[runs.back().first];
+    if (runs.back().first == 16)
+      ++lengthFrequencies[runs[runs.size() - 2].first];
+    j += run;
+  }
+
+  static const int lengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11,
+      4, 12, 3, 13, 2, 14, 1, 15 };
+  std::vector<int> codeLengths;
+  HuffmanCodeLengths(lengthFrequencies, 7, codeLengths);
+  size_t codeLengthCount = 19;
+  while (codeLengthCount > 4 &&
+      codeLengths[lengthOrder[codeLengthCount - 1]] == 0)
+    --codeLengthCount;
+
+  // Pick the smallest of the dynamic codes, the fixed codes, and storing the
+  // data; every block type is counted in bits.
+  size_t extraBits = 0, dynamicBits = 0, fixedBits = 0;
+  for (size_t s = 0; s < 286; ++s)
+  {
+    dynamicBits += literalFrequencies[s] * literalLengths[s];
+    fixedBits += literalFrequencies[s] * fixedLiteralLengths[s];
+    if (s >= 257)
+      extraBits += literalFrequencies[s] * lengthExtra[s - 257];
+  }
+  for (size_t s = 0; s < 30; ++s)
+  {
+    dynamicBits += distanceFrequencies[s] * distanceLengths[s];
+    fixedBits += distanceFrequencies[s] * 5;
+    extraBits += distanceFrequencies[s] * distanceExtra[s];
+  }
+  dynamicBits += 14 + 3 * codeLengthCount;
+  for (const std::pair<int, int>& run : runs)
+  {
+    dynamicBits += codeLengths[run.first] +
+        (run.first == 16 ? 2 : run.first == 17 ? 3 : run.first == 18 ? 7 : 0);
+  }
+  dynamicBits += extraBits;
+  fixedBits += extraBits;
+  const size_t storedBits = 8 * (n + 5 * (std::max)((n + 65534) / 65535,
+      size_t(1)));
+
+  // zlib header: deflate with a 32K window, no dictionary, fastest level.
+  compressed.push_back(0x78);
+  compressed.push_back(0x01);
+
+  DeflateBitWriter writer(compressed);
+  if (storedBits < (std::min)(dynamicBits, fixedBits) + 3)
+  {
+    // Data that doesn't compress, like noise, is stored in blocks of at most
+    // 65535 bytes with their length and its complement.
+    size_t j = 0;
+    do
+    {
+      const size_t length = (std::min)(n - j, size_t(65535));
+      compressed.push_back(j + length == n ? 1 : 0);
+      for (const uint32_t v : { (uint32_t) length, (uint32_t) ~length })
+      {
+        compressed.push_back(static_cast<char>(v & 0xFF));
+        compressed.push_back(static_cast<char>((v >> 8) & 0xFF));
+      }
+      compressed.append((const char*) data + j, length);
+      j += length;
+    } while (j < n);
+  }
+  else
+  {
+    const bool dynamic = dynamicBits < fixedBits;
+    writer.Put(1, 1);
+    writer.Put(dynamic ? 2 : 1, 2);
+    if (dynamic)
+    {
+      std::vector<uint32_t> lengthCodes;
+      HuffmanCodes(codeLengths, lengthCodes);
+      writer.Put(literalCount - 257, 5);
+      writer.Put(distanceCount - 1, 5);
+      writer.Put(codeLengthCount - 4, 4);
+      for (size_t j = 0; j < codeLengthCount; ++j)
+        writer.Put(codeLengths[lengthOrder[j]], 3);
+      for (const std::pair<int, int>& run : runs)
+      {
+        writer.Put(lengthCodes[run.first], codeLengths[run.first]);
+        if (run.first == 16)
+          writer.Put(run.second - 3, 2);
+        else if (run.first == 17)
+          writer.Put(run.second - 3, 3);
+        else if (run.first == 18)
+          writer.Put(run.second - 11, 7);
+      }
+    }
+    else
+    {
+      literalLengths = fixedLiteralLengths;
+      distanceLengths = fixedDistanceLengths;
+    }
+
+    std::vector<uint32_t> literalCodes, distanceCodes;
+    HuffmanCodes(literalLengths, literalCodes);
+    HuffmanCodes(distanceLengths, distanceCodes);
+    for (const Token& token : tokens)
+    {
+      if (token.length == 0)
+      {
+        writer.Put(literalCodes[token.value], literalLengths[token.value]);
+        continue;
+      }
+
+      const int code = codes.lengthCodes[token.length];
+      writer.Put(literalCodes[257 + code], literalLengths[257 + code]);
+      writer.Put(token.length - lengthBase[code], lengthExtra[code]);
+
+      const int distanceCode = codes.Distance(token.value);
+      writer.Put(distanceCodes[distanceCode], distanceLengths[distanceCode]);
+      writer.Put(token.value - distanceBase[distanceCode],
+          distanceExtra[distanceCode]);
+    }
+    writer.Put(literalCodes[256], literalLengths[256]);
+    writer.Flush();
+  }
+
+  // Adler-32 of the data, most significant byte first.
+  uint32_t s1 = 1, s2 = 0;
+  for (size_t j = 0; j < n; )
+  {
+    // 5552 bytes can be summed before the sums have to be reduced.
+    const size_t end = (std::min)(n, j + 5552);
+    for (; j < end; ++j)
+    {
+      s1 += data[j];
+      s2 += s1;
+    }
+    s1 %= 65521;
+    s2 %= 65521;
+  }
+  const uint32_t adler = (s2 << 16) | s1;
+  for (int shift = 24; shift >= 0; shift -= 8)
+    compressed.push_back(static_cast<char>((adler >> shift) & 0xFF));
+}
+
+/**
+ * The Paeth predictor of PNG: the neighbour nearest to a + b - c, with a the
+ * byte on the left, b the byte above, and c the byte above on the left.
+ */
+inline int Paeth(const int a, const int b, const int c)
+{
+  const int p = a + b - c;
+  const int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+  return (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+}
+
+inline void EncodePNG(const unsigned char* pixels,
+                      const size_t width,
+                      const size_t height,
+                      const size_t channels,
+                      std::string& encodedImage)
+{
+  if (width == 0 || height == 0)
+    throw std::invalid_argument("A PNG image can't be empty.");
+  if (channels < 1 || channels > 4)
+  {
+    throw std::invalid_argument("A PNG image has 1, 2, 3 or 4 channels, not " +
+        std::to_string(channels) + ".");
+  }
+
+  // Filter every row with the filter that gives the smallest sum of the
+  // magnitudes of the filtered bytes, as a signed byte. The costs of all the
+  // filters are found in one pass, and the best one is applied in another.
+  const size_t rowBytes = width * channels;
+  const std::vector<unsigned char> zeros(rowBytes, 0);
+  std::vector<unsigned char> filtered(height * (rowBytes + 1));
+  for (size_t y = 0; y < height; ++y)
+  {
+    const unsigned char* row = pixels + y * rowBytes;
+    const unsigned char* up = y > 0 ? row - rowBytes : zeros.data();
+    size_t cost[5] = { 0, 0, 0, 0, 0 };
+    for (size_t x = 0; x < rowBytes; ++x)
+    {
+      const int a = x >= channels ? row[x - channels] : 0;
+      const int b = up[x];
+      const int c = x >= channels ? up[x - channels] : 0;
+      const int v = row[x];
+      cost[0] += std::abs((int) (signed char) v);
+      cost[1] += std::abs((int) (signed char) (v - a));
+      cost[2] += std::abs((int) (signed char) (v - b));
+      cost[3] += std::abs((int) (signed char) (v - ((a + b) >> 1)));
+      cost[4] += std::abs((int) (signed char) (v - Paeth(a, b, c)));
+    }
+    const int filter = std::min_element(cost, cost + 5) - cost;
+
+    unsigned char* out = filtered.data() + y * (rowBytes + 1);
+    out[0] = static_cast<unsigned char>(filter);
+    for (size_t x = 0; x < rowBytes; ++x)
+    {
+      const int a = x >= channels ? row[x - channels] : 0;
+      const int b = up[x];
+      const int c = x >= channels ? up[x - channels] : 0;
+      const int predictor = filter == 0 ? 0 : filter == 1 ? a :
+          filter == 2 ? b : filter == 3 ? (a + b) >> 1 : Paeth(a, b, c);
+      out[x + 1] = static_cast<unsigned char>(row[x] - predictor);
+    }
+  }
+
+  encodedImage.clear();
+  const unsigned char signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+  encodedImage.append((const char*) signature, 8);
+
+  // Every chunk is its length, its type and its data, then the CRC of the
+  // type and the data.
+  auto appendChunk = [&encodedImage](const char* type, const std::string& data)
+  {
+    const uint32_t length = data.size();
+    for (int shift = 24; shift >= 0; shift -= 8)
+      encodedImage.push_back(static_cast<char>((length >> shift) & 0xFF));
+    const size_t begin = encodedImage.size();
+    encodedImage.append(type, 4);
+    encodedImage.append(data);
+    const uint32_t crc = PNGCrc32(0,
+        (const unsigned char*) encodedImage.data() + begin, data.size() + 4);
+    for (int shift = 24; shift >= 0; shift -= 8)
+      encodedImage.push_back(static_cast<char>((crc >> shift) & 0xFF));
+  };
+
+  // Width, height, 8 bits per sample, color type, and the default
+  // compression, filter and interlace methods.
+  static const char colorTypes[5] = { 0, 0, 4, 2, 6 };
+  std::string header;
+  for (const uint32_t size : { (uint32_t) width, (uint32_t) height })
+  {
+    for (int shift = 24; shift >= 0; shift -= 8)
+      header.push_back(static_cast<char>((size >> shift) & 0xFF));
+  }
+  header.push_back(8);
+  header.push_back(colorTypes[channels]);
+  header.append(3, 0);
+  appendChunk("IHDR", header);
+
+  std::string data;
+  ZlibCompress(filtered.data(), filtered.size(), data);
+  appendChunk("IDAT", data);
+  appendChunk("IEND", std::string());
+}
+
+inline unsigned char QuantizePixel(const double value)
+{
+  // The argument order sends NaN to 0.
+  return (unsigned char) ((std::min)((std::max)(0.0, value), 255.0) + 0.5);
+}
+
+template<typename eT>
+void EncodePNG(const eT* pixels,
+               const size_t width,
+               const size_t height,
+               const size_t channels,
+               std::string& encodedImage)
+{
+  static_assert(std::is_arithmetic<eT>::value,
+      "The pixels of an image have to be arithmetic.");
+  std::vector<unsigned char> bytes(width * height * channels);
+  for (size_t i = 0; i < bytes.size(); ++i)
+    bytes[i] = QuantizePixel(pixels[i]);
+
+  EncodePNG(bytes.data(), width, height, channels, encodedImage);
+}
+
+template<typename eT>
+void EncodePNG(const arma::Mat<eT>& images,
+               const size_t width,
+               const size_t height,
+               const size_t channels,
+               std::vector<std::string>& encodedImages)
+{
+  const size_t n = images.n_cols;
+  encodedImages.resize(n);
+
+  // An exception can't leave an OpenMP region, so the first one is kept and
+  // thrown once every column is done.
+  std::exception_ptr error;
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic) if (n > 1)
+#endif
+  for (ptrdiff_t i = 0; i < (ptrdiff_t) n; ++i)
+  {
+    try
+    {
+      EncodePNG(images.colptr(i), width, height, channels, encodedImages[i]);
+    }
+    catch (...)
+    {
+#ifdef _OPENMP
+      #pragma omp critical
+#endif
+      {
+        if (!error)
+          error = std::current_exception();
+      }
+    }
+  }
+
+  if (error)
+    std::rethrow_exception(error);
+}
+
+} // namespace util
+} // namespace mlboard
+
+#endif
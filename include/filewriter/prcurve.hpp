@@ -0,0 +1,224 @@
+/**
+ * @file filewriter/prcurve.hpp
+ *
+ * Kernels that count the true and false positives of a PR curve.
+ */
+#ifndef MLBOARD_PR_CURVE_HPP
+#define MLBOARD_PR_CURVE_HPP
+
+#include <mlboard/core.hpp>
+
+namespace mlboard {
+namespace util {
+
+/**
+ * Class holding the weighted true and false positives of the predictions of
+ * a PR curve in every threshold bucket, before they are summed up into the
+ * counts above every threshold.
+ */
+class PRCurveCounts
+{
+ public:
+  /**
+   * Create the counts of a PR curve without predictions.
+   *
+   * @param thresholds Number of thresholds.
+   */
+  PRCurveCounts(const size_t thresholds = 0);
+
+  /**
+   * Add the counts of other predictions, with the same thresholds.
+   *
+   * @param other Counts to add.
+   */
+  void Merge(const PRCurveCounts& other);
+
+  //! Get the number of thresholds.
+  size_t Thresholds() const { return truePositives.size(); }
+  //! Get the weighted true positives in every bucket.
+  const std::vector<double>& TruePositives() const { return truePositives; }
+  //! Modify the weighted true positives in every bucket.
+  std::vector<double>& TruePositives() { return truePositives; }
+  //! Get the weighted false positives in every bucket.
+  const std::vector<double>& FalsePositives() const { return falsePositives; }
+  //! Modify the weighted false positives in every bucket.
+  std::vector<double>& FalsePositives() { return falsePositives; }
+
+ private:
+  //! Weighted true positives in every bucket.
+  std::vector<double> truePositives;
+
+  //! Weighted false positives in every bucket.
+  std::vector<double> falsePositives;
+};
+
+/**
+ * Function to add labelled predictions to the counts of a PR curve. The
+ * thresholds are uniform, so a prediction p goes straight to bucket
+ * floor(p * (thresholds - 1)); predictions outside [0, 1] go to the first or
+ * the last bucket, and NaN to the first. If mlboard is built with OpenMP and
+ * there are at least PRCurveParallelSize() predictions, they are split among
+ * the threads, and the counts of every thread are merged afterwards.
+ *
+ * @tparam eT Arithmetic type of the labels, predictions and weights.
+ * @param labels Pointer to the labels, 1 for positive and 0 for negative.
+ * @param predictions Pointer to the predictions, in [0, 1].
+ * @param weights Pointer to the weights of the labels, or nullptr to weigh
+ *     every label 1.
+ * @param n Number of predictions.
+ * @param counts Counts the predictions are added to.
+ */
+template<typename eT>
+void PRCurveUpdate(const eT* labels,
+                   const eT* predictions,
+                   const eT* weights,
+                   const size_t n,
+                   PRCurveCounts& counts);
+
+/**
+ * Function to add the class scores of labelled points to the one-vs-rest
+ * counts of the PR curves of every class, in a single pass over the scores.
+ * The scores are column-major with a column per point, as in arma::mat, so
+ * the scores of a point are contiguous; class c counts the points labelled c
+ * as positive and all other points as negative. The predictions are bucketed
+ * like PRCurveUpdate(). If mlboard is built with OpenMP and there are at
+ * least PRCurveParallelSize() scores, the classes are split among the
+ * threads, and every thread only writes the counts of its own classes.
+ *
+ * @tparam eT Arithmetic type of the scores and weights.
+ * @tparam LabelType Arithmetic type of the labels.
+ * @param scores Pointer to the scores, a column of one score per class for
+ *     every point.
+ * @param labels Pointer to the class of every point.
+ * @param weights Pointer to the weights of the points, or nullptr to weigh
+ *     every point 1.
+ * @param n Number of points.
+ * @param counts Counts of every class the scores are added to.
+ */
+template<typename eT, typename LabelType>
+void MultiClassPRCurveUpdate(const eT* scores,
+                             const LabelType* labels,
+                             const eT* weights,
+                             const size_t n,
+                             std::vector<PRCurveCounts>& counts);
+
+/**
+ * Function to get and modify the number of predictions from which
+ * PRCurveUpdate() and MultiClassPRCurveUpdate() run in parallel (1 << 18 by
+ * default).
+ */
+size_t& PRCurveParallelSize();
+
+/**
+ * Kernel of PRCurveUpdate() on a single thread.
+ */
+template<typename eT>
+void PRCurveKernel(const eT* labels,
+                   const eT* predictions,
+                   const eT* weights,
+                   const size_t n,
+                   PRCurveCounts& counts);
+
+/**
+ * Kernel of MultiClassPRCurveUpdate() on a single thread, for the classes in
+ * [begin, end).
+ */
+template<typename eT, typename LabelType>
+void MultiClassPRCurveKernel(const eT* scores,
+                             const LabelType* labels,
+                             const eT* weights,
+                             const size_t n,
+                             std::vector<PRCurveCounts>& counts,
+                             const size_t begin,
+                             const size_t end);
+
+} // namespace util
+
+/**
+ * Class to count the true and false positives of a PR curve over labelled
+ * predictions that arrive in many batches, such as an evaluation set that is
+ * streamed through the model. Only the counts of every threshold bucket are
+ * kept, so the memory doesn't grow with the number of predictions, and the
+ * curve can be logged at any step with SummaryWriter::PRCurve(). An
+ * accumulator isn't shared between threads; give every thread its own and
+ * Merge() them.
+ */
+class PRCurveAccumulator
+{
+ public:
+  /**
+   * Create an accumulator without predictions.
+   *
+   * @param thresholds Number of thresholds.
+   */
+  PRCurveAccumulator(const size_t thresholds = 127);
+
+  /**
+   * Add labelled predictions in memory.
+   *
+   * @tparam eT Arithmetic type of the labels, predictions and weights.
+   * @param labels Pointer to the labels, 1 for positive and 0 for negative.
+   * @param predictions Pointer to the predictions, in [0, 1].
+   * @param n Number of predictions.
+   * @param weights Pointer to the weights of the labels, or nullptr to weigh
+   *     every label 1.
+   */
+  template<typename eT>
+  void Add(const eT* labels,
+           const eT* predictions,
+           const size_t n,
+           const eT* weights = nullptr);
+
+  /**
+   * Add the labelled predictions of vectors. Labels without a weight weigh 1.
+   *
+   * @param labels Labels, 1 for positive and 0 for negative.
+   * @param predictions Predictions, in [0, 1].
+   * @param weights Weights of the labels.
+   */
+  template<typename eT>
+  void Add(const std::vector<eT>& labels,
+           const std::vector<eT>& predictions,
+           const std::vector<eT>& weights = {});
+
+  /**
+   * Add the labelled predictions of Armadillo vectors, either rowvec or
+   * colvec. Labels without a weight weigh 1.
+   *
+   * @param labels Labels, 1 for positive and 0 for negative.
+   * @param predictions Predictions, in [0, 1].
+   * @param weights Weights of the labels.
+   */
+  template<typename VecType>
+  void Add(const VecType& labels,
+           const VecType& predictions,
+           const VecType& weights = VecType());
+
+  /**
+   * Add the counts of another accumulator with the same thresholds.
+   *
+   * @param other Accumulator to add.
+   */
+  void Merge(const PRCurveAccumulator& other);
+
+  /**
+   * Forget all the predictions, keeping the thresholds.
+   */
+  void Reset();
+
+  //! Get the number of thresholds.
+  size_t Thresholds() const { return counts.Thresholds(); }
+  //! Get the counts of the predictions added so far.
+  const util::PRCurveCounts& Counts() const { return counts; }
+
+ private:
+  //! Counts of the predictions added so far.
+  util::PRCurveCounts counts;
+};
+
+} // namespace mlboard
+
+// Include implementation.
+#include "prcurve_impl.hpp"
+
+#endif
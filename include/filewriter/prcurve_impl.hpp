@@ -0,0 +1,254 @@
+/**
+ * @file filewriter/prcurve_impl.hpp
+ *
+ * Implementation of the PR curve kernels.
+ */
+#ifndef MLBOARD_PR_CURVE_IMPL_HPP
+#define MLBOARD_PR_CURVE_IMPL_HPP
+
+#include "prcurve.hpp"
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlboard {
+namespace util {
+
+inline PRCurveCounts::PRCurveCounts(const size_t thresholds) :
+    truePositives(thresholds, 0),
+    falsePositives(thresholds, 0)
+{
+  // Nothing to do here.
+}
+
+inline void PRCurveCounts::Merge(const PRCurveCounts& other)
+{
+  for (size_t i = 0; i < truePositives.size(); ++i)
+  {
+    truePositives[i] += other.truePositives[i];
+    falsePositives[i] += other.falsePositives[i];
+  }
+}
+
+inline size_t& PRCurveParallelSize()
+{
+  static size_t size = 1 << 18;
+  return size;
+}
+
+template<typename eT>
+void PRCurveKernel(const eT* labels,
+                   const eT* predictions,
+                   const eT* weights,
+                   const size_t n,
+                   PRCurveCounts& counts)
+{
+  static_assert(std::is_arithmetic<eT>::value,
+      "The labels and predictions of a PR curve have to be arithmetic.");
+  if (counts.Thresholds() == 0)
+    return;
+
+  // The bucket is clamped before the conversion, which compiles to min, max
+  // and a truncation without branches; the argument order sends NaN to 0.
+  const double last = counts.Thresholds() - 1;
+  double* truePositives = counts.TruePositives().data();
+  double* falsePositives = counts.FalsePositives().data();
+  for (size_t i = 0; i < n; ++i)
+  {
+    const double scaled = (std::min)((std::max)(0.0,
+        static_cast<double>(predictions[i]) * last), last);
+    const size_t bucket = static_cast<size_t>(scaled);
+    const double label = labels[i];
+    const double weight = weights ? static_cast<double>(weights[i]) : 1.0;
+    truePositives[bucket] += label * weight;
+    falsePositives[bucket] += (1 - label) * weight;
+  }
+}
+
+template<typename eT>
+void PRCurveUpdate(const eT* labels,
+                   const eT* predictions,
+                   const eT* weights,
+                   const size_t n,
+                   PRCurveCounts& counts)
+{
+#ifdef _OPENMP
+  const int threads = omp_get_max_threads();
+  if (n >= PRCurveParallelSize() && threads > 1 && !omp_in_parallel())
+  {
+    // Every thread takes a contiguous part of the predictions and its own
+    // counts, so the threads don't share anything until the merge.
+    std::vector<PRCurveCounts> partial(threads,
+        PRCurveCounts(counts.Thresholds()));
+    #pragma omp parallel num_threads(threads)
+    {
+      const size_t thread = omp_get_thread_num();
+      const size_t count = omp_get_num_threads();
+      const size_t begin = n * thread / count;
+      const size_t end = n * (thread + 1) / count;
+      PRCurveKernel(labels + begin, predictions + begin,
+          weights ? weights + begin : weights, end - begin, partial[thread]);
+    }
+
+    for (size_t i = 0; i < partial.size(); ++i)
+      counts.Merge(partial[i]);
+    return;
+  }
+#endif
+
+  PRCurveKernel(labels, predictions, weights, n, counts);
+}
+
+template<typename eT, typename LabelType>
+void MultiClassPRCurveKernel(const eT* scores,
+                             const LabelType* labels,
+                             const eT* weights,
+                             const size_t n,
+                             std::vector<PRCurveCounts>& counts,
+                             const size_t begin,
+                             const size_t end)
+{
+  static_assert(std::is_arithmetic<eT>::value &&
+      std::is_arithmetic<LabelType>::value,
+      "The labels and scores of a PR curve have to be arithmetic.");
+  const size_t classes = counts.size();
+  if (begin >= end || counts[0].Thresholds() == 0)
+    return;
+
+  // Every class has the same thresholds; the counts of the classes are
+  // looked up once, and then filled point by point.
+  const double last = counts[0].Thresholds() - 1;
+  std::vector<double*> truePositives(end - begin);
+  std::vector<double*> falsePositives(end - begin);
+  for (size_t c = begin; c < end; ++c)
+  {
+    truePositives[c - begin] = counts[c].TruePositives().data();
+    falsePositives[c - begin] = counts[c].FalsePositives().data();
+  }
+
+  for (size_t i = 0; i < n; ++i)
+  {
+    const eT* point = scores + i * classes;
+    const double weight = weights ? static_cast<double>(weights[i]) : 1.0;
+    const double pointClass = labels[i];
+    for (size_t c = begin; c < end; ++c)
+    {
+      const double scaled = (std::min)((std::max)(0.0,
+          static_cast<double>(point[c]) * last), last);
+      const size_t bucket = static_cast<size_t>(scaled);
+      const double label = (pointClass == c);
+      truePositives[c - begin][bucket] += label * weight;
+      falsePositives[c - begin][bucket] += (1 - label) * weight;
+    }
+  }
+}
+
+template<typename eT, typename LabelType>
+void MultiClassPRCurveUpdate(const eT* scores,
+                             const LabelType* labels,
+                             const eT* weights,
+                             const size_t n,
+                             std::vector<PRCurveCounts>& counts)
+{
+  const size_t classes = counts.size();
+#ifdef _OPENMP
+  const int threads = omp_get_max_threads();
+  if (n * classes >= PRCurveParallelSize() && classes > 1 && threads > 1 &&
+      !omp_in_parallel())
+  {
+    // Every thread scans all the points, but only reads and writes the
+    // scores and counts of its own classes, so nothing has to be merged.
+    #pragma omp parallel num_threads((std::min)(threads, (int) classes))
+    {
+      const size_t thread = omp_get_thread_num();
+      const size_t count = omp_get_num_threads();
+      MultiClassPRCurveKernel(scores, labels, weights, n, counts,
+          classes * thread / count, classes * (thread + 1) / count);
+    }
+    return;
+  }
+#endif
+
+  MultiClassPRCurveKernel(scores, labels, weights, n, counts, 0, classes);
+}
+
+} // namespace util
+
+inline PRCurveAccumulator::PRCurveAccumulator(const size_t thresholds) :
+    counts(thresholds)
+{
+  // Nothing to do here.
+}
+
+template<typename eT>
+void PRCurveAccumulator::Add(const eT* labels,
+                             const eT* predictions,
+                             const size_t n,
+                             const eT* weights)
+{
+  util::PRCurveUpdate(labels, predictions, weights, n, counts);
+}
+
+template<typename eT>
+void PRCurveAccumulator::Add(const std::vector<eT>& labels,
+                             const std::vector<eT>& predictions,
+                             const std::vector<eT>& weights)
+{
+  const size_t n = (std::min)(labels.size(), predictions.size());
+  if (weights.empty())
+  {
+    Add(labels.data(), predictions.data(), n, (const eT*) nullptr);
+    return;
+  }
+  else if (weights.size() >= n)
+  {
+    Add(labels.data(), predictions.data(), n, weights.data());
+    return;
+  }
+
+  // Only weights shorter than the labels are copied, to weigh the remaining
+  // labels 1.
+  std::vector<eT> paddedWeights(n, 1);
+  std::copy(weights.begin(), weights.end(), paddedWeights.begin());
+  Add(labels.data(), predictions.data(), n, paddedWeights.data());
+}
+
+template<typename VecType>
+void PRCurveAccumulator::Add(const VecType& labels,
+                             const VecType& predictions,
+                             const VecType& weights)
+{
+  typedef typename VecType::elem_type eT;
+
+  const size_t n = (std::min)(labels.n_elem, predictions.n_elem);
+  if (weights.n_elem == 0)
+  {
+    Add(labels.memptr(), predictions.memptr(), n, (const eT*) nullptr);
+    return;
+  }
+  else if (weights.n_elem >= n)
+  {
+    Add(labels.memptr(), predictions.memptr(), n, weights.memptr());
+    return;
+  }
+
+  std::vector<eT> paddedWeights(n, 1);
+  std::copy(weights.memptr(), weights.memptr() + weights.n_elem,
+      paddedWeights.begin());
+  Add(labels.memptr(), predictions.memptr(), n, paddedWeights.data());
+}
+
+inline void PRCurveAccumulator::Merge(const PRCurveAccumulator& other)
+{
+  counts.Merge(other.counts);
+}
+
+inline void PRCurveAccumulator::Reset()
+{
+  counts = util::PRCurveCounts(counts.Thresholds());
+}
+
+} // namespace mlboard
+
+#endif
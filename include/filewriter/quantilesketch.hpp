@@ -0,0 +1,208 @@
+/**
+ * @file filewriter/quantilesketch.hpp
+ *
+ * A mergeable quantile sketch with bounded memory, that can be logged as a
+ * histogram.
+ */
+#ifndef MLBOARD_QUANTILE_SKETCH_HPP
+#define MLBOARD_QUANTILE_SKETCH_HPP
+
+#include <mlboard/core.hpp>
+
+namespace mlboard {
+
+/**
+ * Class to sketch the distribution of values that arrive in many batches or
+ * on many threads, as a DDSketch. The magnitude of a value goes to bucket i
+ * if it lies in (gamma^(i-1), gamma^i], with
+ * gamma = (1 + relativeAccuracy) / (1 - relativeAccuracy), so every quantile
+ * is known within the relative accuracy. Positive and negative values have
+ * their own buckets, and values too small to have a bucket are counted as
+ * zero. The buckets adapt to the range of the values, unlike the fixed edges
+ * of a histogram, and sketches with the same accuracy can be merged by adding
+ * their counts.
+ *
+ * The memory is bounded by the maximum number of buckets for each sign: once
+ * it is reached, the buckets of the smallest magnitudes are collapsed into
+ * one, so the quantiles of large magnitudes stay accurate.
+ *
+ * The sketch is logged with SummaryWriter::Histogram(), which writes every
+ * non-empty bucket with its upper edge as the bucket limit. A sketch isn't
+ * shared between threads; give every thread its own and Merge() them.
+ */
+class QuantileSketch
+{
+ public:
+  /**
+   * Create an empty sketch.
+   *
+   * @param relativeAccuracy Relative accuracy of the quantiles, in (0, 1).
+   * @param maxBuckets Maximum number of buckets for each sign.
+   */
+  QuantileSketch(const double relativeAccuracy = 0.01,
+                 const size_t maxBuckets = 2048);
+
+  /**
+   * Add a value. NaN is ignored.
+   *
+   * @param value Value to add.
+   */
+  void Add(const double value);
+
+  /**
+   * Add values in memory.
+   *
+   * @tparam eT Arithmetic type of the values.
+   * @param values Pointer to the values.
+   * @param n Number of values.
+   */
+  template<typename eT>
+  void Add(const eT* values, const size_t n);
+
+  /**
+   * Add the values of a vector.
+   *
+   * @param values Values to add.
+   */
+  template<typename eT>
+  void Add(const std::vector<eT>& values);
+
+  /**
+   * Add the values of an Armadillo matrix or vector, such as arma::mat or
+   * arma::frowvec.
+   *
+   * @param values Values to add.
+   */
+  template<typename MatType>
+  void Add(const MatType& values,
+           typename std::enable_if<
+               !std::is_arithmetic<MatType>::value>::type* = 0);
+
+  /**
+   * Add the values of another sketch with the same relative accuracy. It
+   * throws std::invalid_argument if the accuracies differ.
+   *
+   * @param other Sketch to add.
+   */
+  void Merge(const QuantileSketch& other);
+
+  /**
+   * Get a quantile of the values, within the relative accuracy. It is 0 if
+   * there are no values.
+   *
+   * @param q The quantile, in [0, 1].
+   */
+  double Quantile(const double q) const;
+
+  /**
+   * Get the non-empty buckets in increasing order, as the upper edge of
+   * every bucket and the number of values in it; the format of
+   * HistogramProto.
+   *
+   * @param limits Output upper edges of the buckets.
+   * @param counts Output number of values in every bucket.
+   */
+  void Buckets(std::vector<double>& limits, std::vector<double>& counts) const;
+
+  /**
+   * Forget all the values, keeping the accuracy.
+   */
+  void Reset();
+
+  //! Get the relative accuracy.
+  double RelativeAccuracy() const { return relativeAccuracy; }
+  //! Get the maximum number of buckets for each sign.
+  size_t MaxBuckets() const { return maxBuckets; }
+  //! Get the number of values.
+  size_t Num() const { return num; }
+  //! Get the smallest value.
+  double Min() const { return min; }
+  //! Get the largest value.
+  double Max() const { return max; }
+  //! Get the sum of the values.
+  double Sum() const { return sum; }
+  //! Get the sum of the squares of the values.
+  double SumSquares() const { return sumSquares; }
+
+ private:
+  /**
+   * Counts of consecutive buckets, starting at an offset. Buckets below the
+   * highest maxBuckets are collapsed into the lowest one that is kept.
+   */
+  class Store
+  {
+   public:
+    //! Create an empty store.
+    Store() : offset(0), total(0) { }
+
+    //! Add values to a bucket.
+    void Add(const int64_t index,
+             const size_t count,
+             const size_t maxBuckets);
+
+    //! Get the index of the first bucket.
+    int64_t Offset() const { return offset; }
+    //! Get the counts of the buckets.
+    const std::vector<size_t>& Counts() const { return counts; }
+    //! Get the number of values.
+    size_t Total() const { return total; }
+
+   private:
+    //! Index of the first bucket.
+    int64_t offset;
+
+    //! Counts of the buckets.
+    std::vector<size_t> counts;
+
+    //! Number of values.
+    size_t total;
+  };
+
+  //! Get the bucket of a positive magnitude; infinity goes to the bucket of
+  //! the largest double.
+  int64_t Index(const double magnitude) const
+  {
+    return static_cast<int64_t>(std::ceil(std::log((std::min)(magnitude,
+        std::numeric_limits<double>::max())) / logGamma));
+  }
+
+  //! Relative accuracy of the quantiles.
+  double relativeAccuracy;
+
+  //! Maximum number of buckets for each sign.
+  size_t maxBuckets;
+
+  //! Logarithm of the ratio between the edges of two buckets.
+  double logGamma;
+
+  //! Buckets of the positive values.
+  Store positive;
+
+  //! Buckets of the negative values, by magnitude.
+  Store negative;
+
+  //! Number of values too small to have a bucket.
+  size_t zeroCount;
+
+  //! Number of values.
+  size_t num;
+
+  //! Smallest value.
+  double min;
+
+  //! Largest value.
+  double max;
+
+  //! Sum of the values.
+  double sum;
+
+  //! Sum of the squares of the values.
+  double sumSquares;
+};
+
+} // namespace mlboard
+
+// Include implementation.
+#include "quantilesketch_impl.hpp"
+
+#endif
@@ -0,0 +1,247 @@
+/**
+ * @file filewriter/quantilesketch_impl.hpp
+ *
+ * Implementation of the quantile sketch.
+ */
+#ifndef MLBOARD_QUANTILE_SKETCH_IMPL_HPP
+#define MLBOARD_QUANTILE_SKETCH_IMPL_HPP
+
+#include "quantilesketch.hpp"
+
+namespace mlboard {
+
+inline void QuantileSketch::Store::Add(const int64_t index,
+                                       const size_t count,
+                                       const size_t maxBuckets)
+{
+  total += count;
+  if (counts.empty())
+  {
+    offset = index;
+    counts.assign(1, count);
+    return;
+  }
+
+  // Keep the highest maxBuckets buckets; lower ones are collapsed into the
+  // lowest bucket that is kept.
+  const int64_t last = offset + static_cast<int64_t>(counts.size()) - 1;
+  const int64_t high = (std::max)(index, last);
+  const int64_t low = (std::max)((std::min)(index, offset),
+      high - static_cast<int64_t>(maxBuckets) + 1);
+  if (low != offset || high != last)
+  {
+    if (low == offset)
+    {
+      counts.resize(high - low + 1, 0);
+    }
+    else
+    {
+      std::vector<size_t> range(high - low + 1, 0);
+      for (size_t i = 0; i < counts.size(); ++i)
+      {
+        range[(std::max)(offset + static_cast<int64_t>(i), low) - low] +=
+            counts[i];
+      }
+      counts.swap(range);
+      offset = low;
+    }
+  }
+
+  counts[(std::max)(index, low) - offset] += count;
+}
+
+inline QuantileSketch::QuantileSketch(const double relativeAccuracy,
+                                      const size_t maxBuckets) :
+    relativeAccuracy(relativeAccuracy),
+    maxBuckets(maxBuckets)
+{
+  if (!(relativeAccuracy > 0 && relativeAccuracy < 1))
+  {
+    throw std::invalid_argument("The relative accuracy of a QuantileSketch "
+        "has to be in (0, 1).");
+  }
+  if (maxBuckets == 0)
+  {
+    throw std::invalid_argument("A QuantileSketch needs at least one "
+        "bucket.");
+  }
+
+  logGamma = std::log1p(2 * relativeAccuracy / (1 - relativeAccuracy));
+  Reset();
+}
+
+inline void QuantileSketch::Add(const double value)
+{
+  if (std::isnan(value))
+    return;
+
+  const double magnitude = std::fabs(value);
+  if (magnitude < std::numeric_limits<double>::min())
+    ++zeroCount;
+  else if (value > 0)
+    positive.Add(Index(magnitude), 1, maxBuckets);
+  else
+    negative.Add(Index(magnitude), 1, maxBuckets);
+
+  ++num;
+  min = (std::min)(min, value);
+  max = (std::max)(max, value);
+  sum += value;
+  sumSquares += value * value;
+}
+
+template<typename eT>
+void QuantileSketch::Add(const eT* values, const size_t n)
+{
+  static_assert(std::is_arithmetic<eT>::value,
+      "The values of a QuantileSketch have to be arithmetic.");
+  for (size_t i = 0; i < n; ++i)
+    Add(static_cast<double>(values[i]));
+}
+
+template<typename eT>
+void QuantileSketch::Add(const std::vector<eT>& values)
+{
+  Add(values.data(), values.size());
+}
+
+template<typename MatType>
+void QuantileSketch::Add(
+    const MatType& values,
+    typename std::enable_if<!std::is_arithmetic<MatType>::value>::type*)
+{
+  Add(values.memptr(), values.n_elem);
+}
+
+inline void QuantileSketch::Merge(const QuantileSketch& other)
+{
+  if (other.relativeAccuracy != relativeAccuracy)
+  {
+    throw std::invalid_argument("Only QuantileSketch objects with the same "
+        "relative accuracy can be merged.");
+  }
+
+  for (size_t i = 0; i < other.positive.Counts().size(); ++i)
+  {
+    if (other.positive.Counts()[i] > 0)
+    {
+      positive.Add(other.positive.Offset() + (int64_t) i,
+          other.positive.Counts()[i], maxBuckets);
+    }
+  }
+  for (size_t i = 0; i < other.negative.Counts().size(); ++i)
+  {
+    if (other.negative.Counts()[i] > 0)
+    {
+      negative.Add(other.negative.Offset() + (int64_t) i,
+          other.negative.Counts()[i], maxBuckets);
+    }
+  }
+  zeroCount += other.zeroCount;
+
+  num += other.num;
+  min = (std::min)(min, other.min);
+  max = (std::max)(max, other.max);
+  sum += other.sum;
+  sumSquares += other.sumSquares;
+}
+
+inline double QuantileSketch::Quantile(const double q) const
+{
+  if (num == 0)
+    return 0;
+
+  // The value whose rank is the nearest to the quantile, in increasing
+  // order: negative values from the largest magnitude, zero, then positive
+  // values. Inside a bucket, the value with the smallest relative error to
+  // any magnitude of the bucket is taken.
+  const double gamma = std::exp(logGamma);
+  const size_t rank = static_cast<size_t>(
+      (std::min)((std::max)(q, 0.0), 1.0) * (num - 1) + 0.5);
+  double value = 0;
+  size_t seen = 0;
+  if (rank < negative.Total())
+  {
+    const std::vector<size_t>& counts = negative.Counts();
+    for (size_t i = counts.size(); i-- > 0; )
+    {
+      seen += counts[i];
+      if (seen > rank)
+      {
+        value = -2 * std::exp((negative.Offset() + (int64_t) i) *
+            logGamma) / (gamma + 1);
+        break;
+      }
+    }
+  }
+  else if (rank >= negative.Total() + zeroCount)
+  {
+    seen = negative.Total() + zeroCount;
+    const std::vector<size_t>& counts = positive.Counts();
+    for (size_t i = 0; i < counts.size(); ++i)
+    {
+      seen += counts[i];
+      if (seen > rank)
+      {
+        value = 2 * std::exp((positive.Offset() + (int64_t) i) *
+            logGamma) / (gamma + 1);
+        break;
+      }
+    }
+  }
+
+  return (std::min)((std::max)(value, min), max);
+}
+
+inline void QuantileSketch::Buckets(std::vector<double>& limits,
+                                    std::vector<double>& counts) const
+{
+  limits.clear();
+  counts.clear();
+
+  // The bucket of the negative magnitudes in (gamma^(i-1), gamma^i] ends at
+  // -gamma^(i-1).
+  const std::vector<size_t>& negativeCounts = negative.Counts();
+  for (size_t i = negativeCounts.size(); i-- > 0; )
+  {
+    if (negativeCounts[i] > 0)
+    {
+      limits.push_back(-std::exp((negative.Offset() + (int64_t) i - 1) *
+          logGamma));
+      counts.push_back(negativeCounts[i]);
+    }
+  }
+
+  if (zeroCount > 0)
+  {
+    limits.push_back(0);
+    counts.push_back(zeroCount);
+  }
+
+  const std::vector<size_t>& positiveCounts = positive.Counts();
+  for (size_t i = 0; i < positiveCounts.size(); ++i)
+  {
+    if (positiveCounts[i] > 0)
+    {
+      limits.push_back(std::exp((positive.Offset() + (int64_t) i) *
+          logGamma));
+      counts.push_back(positiveCounts[i]);
+    }
+  }
+}
+
+inline void QuantileSketch::Reset()
+{
+  positive = Store();
+  negative = Store();
+  zeroCount = 0;
+  num = 0;
+  min = std::numeric_limits<double>::max();
+  max = std::numeric_limits<double>::lowest();
+  sum = 0.0;
+  sumSquares = 0.0;
+}
+
+} // namespace mlboard
+
+#endif
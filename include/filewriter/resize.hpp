@@ -0,0 +1,105 @@
+/**
+ * @file filewriter/resize.hpp
+ *
+ * Functions to shrink and quantize images before they are encoded.
+ */
+#ifndef MLBOARD_RESIZE_HPP
+#define MLBOARD_RESIZE_HPP
+
+#include <mlboard/core.hpp>
+#include "png.hpp"
+
+namespace mlboard {
+namespace util {
+
+/**
+ * Filters to resize images with.
+ */
+enum class ResizeFilter
+{
+  //! Every pixel is the average of the source pixels it covers, weighted by
+  //! the covered area. Smooth for any shrink factor; it reads every source
+  //! pixel.
+  Box,
+  //! Every pixel is interpolated from the 2x2 source pixels around its
+  //! center. Only reads the pixels it needs, but aliases when shrinking more
+  //! than twice.
+  Bilinear
+};
+
+/**
+ * Function to resize every column of a matrix of images, in the layout of
+ * mlpack's image matrices, and to quantize it to 8 bits with
+ * QuantizePixel(), like EncodePNG(). If the size doesn't change, the images
+ * are only quantized. The filter is separable, so the rows are resized
+ * first, and then the columns. If mlboard is built with OpenMP, the images
+ * are resized in parallel. It throws std::invalid_argument if a size is 0 or
+ * the number of rows of the matrix isn't the width times the height times
+ * the channels.
+ *
+ * @tparam eT Arithmetic type of the pixels.
+ * @param images Matrix with an image in every column.
+ * @param width Width of the images.
+ * @param height Height of the images.
+ * @param channels Number of channels of the images.
+ * @param newWidth Width of the resized images.
+ * @param newHeight Height of the resized images.
+ * @param filter Filter to resize the images with.
+ * @param resized Output matrix with a resized image in every column.
+ */
+template<typename eT>
+void ResizeImages(const arma::Mat<eT>& images,
+                  const size_t width,
+                  const size_t height,
+                  const size_t channels,
+                  const size_t newWidth,
+                  const size_t newHeight,
+                  const ResizeFilter filter,
+                  arma::Mat<unsigned char>& resized);
+
+/**
+ * Function to get the size of a thumbnail that fits in the given size and
+ * keeps the aspect ratio of the image. Images that already fit keep their
+ * size, and a thumbnail is at least 1x1.
+ *
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param maxWidth Maximum width of the thumbnail, or 0 for no maximum.
+ * @param maxHeight Maximum height of the thumbnail, or 0 for no maximum.
+ * @param newWidth Output width of the thumbnail.
+ * @param newHeight Output height of the thumbnail.
+ */
+void ThumbnailSize(const size_t width,
+                   const size_t height,
+                   const size_t maxWidth,
+                   const size_t maxHeight,
+                   size_t& newWidth,
+                   size_t& newHeight);
+
+/**
+ * Function to compute the weights of the source pixels of every pixel of a
+ * resized row or column. The weights of pixel i are in
+ * weights[offsets[i]] to weights[offsets[i + 1] - 1], for the source pixels
+ * from first[i] on.
+ *
+ * @param size Number of source pixels.
+ * @param newSize Number of resized pixels.
+ * @param filter Filter to resize with.
+ * @param first Output first source pixel of every resized pixel.
+ * @param offsets Output offset of the weights of every resized pixel.
+ * @param weights Output weights.
+ */
+void ResizeWeights(const size_t size,
+                   const size_t newSize,
+                   const ResizeFilter filter,
+                   std::vector<size_t>& first,
+                   std::vector<size_t>& offsets,
+                   std::vector<double>& weights);
+
+} // namespace util
+} // namespace mlboard
+
+// Include implementation.
+#include "resize_impl.hpp"
+
+#endif
@@ -0,0 +1,206 @@
+/**
+ * @file filewriter/resize_impl.hpp
+ *
+ * Implementation of the image resizing functions.
+ */
+#ifndef MLBOARD_RESIZE_IMPL_HPP
+#define MLBOARD_RESIZE_IMPL_HPP
+
+#include "resize.hpp"
+
+namespace mlboard {
+namespace util {
+
+inline void ThumbnailSize(const size_t width,
+                          const size_t height,
+                          const size_t maxWidth,
+                          const size_t maxHeight,
+                          size_t& newWidth,
+                          size_t& newHeight)
+{
+  double scale = 1.0;
+  if (maxWidth > 0 && width > 0)
+    scale = (std::min)(scale, (double) maxWidth / width);
+  if (maxHeight > 0 && height > 0)
+    scale = (std::min)(scale, (double) maxHeight / height);
+
+  newWidth = (std::max)((size_t) std::lround(width * scale), (size_t) 1);
+  newHeight = (std::max)((size_t) std::lround(height * scale), (size_t) 1);
+  if (maxWidth > 0)
+    newWidth = (std::min)(newWidth, maxWidth);
+  if (maxHeight > 0)
+    newHeight = (std::min)(newHeight, maxHeight);
+}
+
+inline void ResizeWeights(const size_t size,
+                          const size_t newSize,
+                          const ResizeFilter filter,
+                          std::vector<size_t>& first,
+                          std::vector<size_t>& offsets,
+                          std::vector<double>& weights)
+{
+  const double scale = (double) size / newSize;
+  first.resize(newSize);
+  offsets.assign(1, 0);
+  weights.clear();
+  for (size_t i = 0; i < newSize; ++i)
+  {
+    if (filter == ResizeFilter::Box)
+    {
+      // The pixel covers [begin, end) of the source, and every source pixel
+      // weighs the part of it that is covered.
+      const double begin = i * scale;
+      const double end = (i + 1) * scale;
+      first[i] = (size_t) begin;
+      const size_t last = (std::min)((size_t) std::ceil(end), size);
+      for (size_t j = first[i]; j < last; ++j)
+      {
+        const double overlap = (std::min)(end, (double) j + 1) -
+            (std::max)(begin, (double) j);
+        weights.push_back(overlap / scale);
+      }
+    }
+    else
+    {
+      // Pixel centers are half a pixel from their edges, in both sizes.
+      const double center = (std::min)((std::max)((i + 0.5) * scale - 0.5,
+          0.0), (double) size - 1);
+      first[i] = (size_t) center;
+      const double fraction = center - first[i];
+      weights.push_back(1 - fraction);
+      if (first[i] + 1 < size)
+        weights.push_back(fraction);
+    }
+    offsets.push_back(weights.size());
+  }
+}
+
+template<typename eT>
+void ResizeImages(const arma::Mat<eT>& images,
+                  const size_t width,
+                  const size_t height,
+                  const size_t channels,
+                  const size_t newWidth,
+                  const size_t newHeight,
+                  const ResizeFilter filter,
+                  arma::Mat<unsigned char>& resized)
+{
+  static_assert(std::is_arithmetic<eT>::value,
+      "The pixels of an image have to be arithmetic.");
+  if (width == 0 || height == 0 || channels == 0 || newWidth == 0 ||
+      newHeight == 0)
+  {
+    throw std::invalid_argument("Can't resize an image from or to a size of "
+        "0.");
+  }
+  if (images.n_rows != width * height * channels)
+  {
+    throw std::invalid_argument("The matrix of images has " +
+        std::to_string(images.n_rows) + " rows, but an image of the given "
+        "size has " + std::to_string(width * height * channels) + " values.");
+  }
+
+  const size_t n = images.n_cols;
+  const size_t rowSize = newWidth * channels;
+  resized.set_size(rowSize * newHeight, n);
+
+  if (newWidth == width && newHeight == height)
+  {
+    const eT* values = images.memptr();
+    unsigned char* pixels = resized.memptr();
+    for (size_t i = 0; i < images.n_elem; ++i)
+      pixels[i] = QuantizePixel(values[i]);
+    return;
+  }
+
+  std::vector<size_t> firstX, offsetsX, firstY, offsetsY;
+  std::vector<double> weightsX, weightsY;
+  ResizeWeights(width, newWidth, filter, firstX, offsetsX, weightsX);
+  ResizeWeights(height, newHeight, filter, firstY, offsetsY, weightsY);
+
+  // Only the source rows that some resized row reads are resized, so the
+  // bilinear filter skips most of them when shrinking.
+  std::vector<char> rowUsed(height, 0);
+  for (size_t y = 0; y < newHeight; ++y)
+  {
+    for (size_t k = offsetsY[y]; k < offsetsY[y + 1]; ++k)
+      rowUsed[firstY[y] + k - offsetsY[y]] = 1;
+  }
+
+  // An exception can't leave an OpenMP region, so the first one is kept and
+  // thrown once every column is done.
+  std::exception_ptr error;
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic) if (n > 1)
+#endif
+  for (ptrdiff_t i = 0; i < (ptrdiff_t) n; ++i)
+  {
+    try
+    {
+      const eT* image = images.colptr(i);
+      unsigned char* pixels = resized.colptr(i);
+
+      // Resize the rows first, into a buffer of newWidth x height.
+      std::vector<double> rows(rowSize * height);
+      for (size_t y = 0; y < height; ++y)
+      {
+        if (!rowUsed[y])
+          continue;
+
+        const eT* row = image + y * width * channels;
+        double* rowOut = rows.data() + y * rowSize;
+        for (size_t x = 0; x < newWidth; ++x)
+        {
+          const eT* source = row + firstX[x] * channels;
+          for (size_t c = 0; c < channels; ++c)
+          {
+            double sum = 0;
+            for (size_t k = offsetsX[x]; k < offsetsX[x + 1]; ++k)
+            {
+              sum += weightsX[k] *
+                  source[(k - offsetsX[x]) * channels + c];
+            }
+            rowOut[x * channels + c] = sum;
+          }
+        }
+      }
+
+      // Then the columns, summing whole resized rows at a time.
+      std::vector<double> sums(rowSize);
+      for (size_t y = 0; y < newHeight; ++y)
+      {
+        std::fill(sums.begin(), sums.end(), 0.0);
+        for (size_t k = offsetsY[y]; k < offsetsY[y + 1]; ++k)
+        {
+          const double weight = weightsY[k];
+          const double* row = rows.data() +
+              (firstY[y] + k - offsetsY[y]) * rowSize;
+          for (size_t j = 0; j < rowSize; ++j)
+            sums[j] += weight * row[j];
+        }
+
+        unsigned char* rowOut = pixels + y * rowSize;
+        for (size_t j = 0; j < rowSize; ++j)
+          rowOut[j] = QuantizePixel(sums[j]);
+      }
+    }
+    catch (...)
+    {
+#ifdef _OPENMP
+      #pragma omp critical
+#endif
+      {
+        if (!error)
+          error = std::current_exception();
+      }
+    }
+  }
+
+  if (error)
+    std::rethrow_exception(error);
+}
+
+} // namespace util
+} // namespace mlboard
+
+#endif
@@ -0,0 +1,199 @@
+/**
+ * @file filewriter/ringqueue.hpp
+ *
+ * A bounded, lock-free multi-producer single-consumer queue that can be used
+ * instead of SharedQueue when many threads log at the same time.
+ */
+#ifndef MLBOARD_RING_QUEUE_HPP
+#define MLBOARD_RING_QUEUE_HPP
+
+#include <mlboard/core.hpp>
+
+namespace mlboard {
+
+/**
+ * Class responsible to share a queue among many producer threads and the
+ * event logger thread without a lock. The elements are stored in a ring
+ * buffer whose size is a power of two; every slot carries a sequence number
+ * that tells producers and the consumer whether the slot is free or holds a
+ * published element. Producers claim slots with a single compare-and-swap on
+ * the tail, and the only consumer advances the head without any atomic
+ * read-modify-write. The head and the tail live on different cache lines, so
+ * producers and the consumer don't invalidate each other's line.
+ *
+ * A producer that finds the queue full yields until the consumer has freed a
+ * slot. The consumer sleeps on a condition variable while it waits, and a
+ * producer only touches that condition variable when the consumer asked to be
+ * woken up.
+ *
+ * @tparam Datatype datatype of the elements queue would be holding. It has to
+ *    be default constructible.
+ */
+template <typename Datatype>
+class RingQueue
+{
+ public:
+  //! The type of the elements in the queue.
+  typedef Datatype ElemType;
+
+  /**
+   * Create an empty, open queue.
+   *
+   * @param maxSize The maximum number of elements in the queue; it is rounded
+   *    up to the next power of two, and to at least two, as a single slot
+   *    can't tell a full cell from an empty one by its sequence number.
+   */
+  RingQueue(const size_t maxSize = 1024);
+
+  /**
+   * Function to pop an element from the queue. Only a single thread may pop
+   * elements.
+   */
+  Datatype Pop();
+
+  /**
+   * Function to move up to the given number of elements from the queue to the
+   * end of the given container, without waiting for new elements. Only a
+   * single thread may pop elements. The slots are handed back to the
+   * producers one by one, but the head is only moved once for the batch.
+   *
+   * @param n The maximum number of elements to pop.
+   * @param items Container the elements are moved to.
+   * @return The number of elements popped.
+   */
+  size_t PopBatch(const size_t n, std::queue<Datatype>& items);
+
+  /**
+   * Function to move every pending element from the queue to the end of the
+   * given container, without waiting for new elements.
+   *
+   * @param items Container the elements are moved to.
+   * @return The number of elements popped.
+   */
+  size_t PopAll(std::queue<Datatype>& items)
+  {
+    return PopBatch(std::numeric_limits<size_t>::max(), items);
+  }
+
+  /**
+   * Function to push a copy of an element in the queue.
+   *
+   * @param item The element to be pushed.
+   */
+  void Push(const Datatype& item) { Emplace(item); }
+
+  /**
+   * Function to move an element into the queue.
+   *
+   * @param item The element to be pushed.
+   */
+  void Push(Datatype&& item) { Emplace(std::move(item)); }
+
+  /**
+   * Function to construct an element in place at the end of the queue.
+   *
+   * @param args Arguments passed to the constructor of the element.
+   */
+  template<typename... Args>
+  void Emplace(Args&&... args);
+
+  /**
+   * Function to block the calling thread until there is something to be
+   * consumed. The thread sleeps until an element is pushed or the queue is
+   * closed; then it keeps sleeping until the given deadline passes, unless
+   * the queue fills up or is closed first.
+   *
+   * @param deadline Point in time until which pending elements can wait.
+   */
+  template<typename Clock, typename Duration>
+  void Wait(const std::chrono::time_point<Clock, Duration>& deadline);
+
+  /**
+   * An overload that stops waiting for a first element at the given idle
+   * deadline, so that the consumer can do its own periodic work while
+   * nothing is pushed.
+   *
+   * @param deadline Point in time until which pending elements can wait.
+   * @param idleDeadline Point in time at which the thread wakes up even if
+   *     nothing was pushed.
+   * @return False if the idle deadline passed without an element, true
+   *     otherwise.
+   */
+  template<typename Clock, typename Duration>
+  bool Wait(const std::chrono::time_point<Clock, Duration>& deadline,
+            const std::chrono::time_point<Clock, Duration>& idleDeadline);
+
+  /**
+   * Function to close the queue and wake up the waiting consumer.
+   */
+  void Close();
+
+  //! Get the size of the queue.
+  size_t Size() const
+  {
+    return tail.load(std::memory_order_acquire) -
+        head.load(std::memory_order_acquire);
+  }
+  //! Get the maximum size of the queue.
+  size_t MaxSize() const { return mask + 1; }
+  //! Check if queue is empty.
+  bool Empty() const { return Size() == 0; }
+  //! Check if queue has been closed.
+  bool Closed() const { return closed; }
+
+ private:
+  //! A slot of the ring buffer.
+  struct Cell
+  {
+    //! Position the slot is ready for; it is one past the position of the
+    //! element while the slot holds a published element.
+    std::atomic<size_t> sequence;
+
+    //! The element stored in the slot.
+    Datatype data;
+  };
+
+  //! Size of the padding that keeps the hot members on their own cache line.
+  static constexpr size_t cacheLineSize = 64;
+
+  //! Wake the consumer if it waits for at least the given number of elements.
+  void Notify(const size_t size);
+
+  //! The slots of the ring buffer.
+  std::unique_ptr<Cell[]> buffer;
+
+  //! Number of slots minus one, used to wrap positions around the buffer.
+  size_t mask;
+
+  char padHead[cacheLineSize];
+
+  //! Position of the next element to be popped; written by the consumer only.
+  std::atomic<size_t> head;
+
+  char padTail[cacheLineSize - sizeof(std::atomic<size_t>)];
+
+  //! Position of the next slot to be claimed by a producer.
+  std::atomic<size_t> tail;
+
+  char padWake[cacheLineSize - sizeof(std::atomic<size_t>)];
+
+  //! Number of elements the waiting consumer wants to see before it is woken
+  //! up, 0 if the consumer isn't waiting.
+  std::atomic<size_t> wakeSize;
+
+  //! A flag that indicates that no more elements will be pushed.
+  std::atomic<bool> closed;
+
+  //! Lock that the consumer holds while it sleeps.
+  std::mutex mutex_;
+
+  //! Condition to wake up the sleeping consumer.
+  std::condition_variable queueempty;
+};
+
+} // namespace mlboard
+
+// Include implementation.
+#include "ringqueue_impl.hpp"
+
+#endif
@@ -0,0 +1,200 @@
+/**
+ * @file filewriter/ringqueue_impl.hpp
+ *
+ * Implementation of the lock-free multi-producer single-consumer queue.
+ */
+#ifndef MLBOARD_RING_QUEUE_IMPL_HPP
+#define MLBOARD_RING_QUEUE_IMPL_HPP
+
+#include "ringqueue.hpp"
+
+namespace mlboard {
+
+template <typename Datatype>
+RingQueue<Datatype>::RingQueue(const size_t maxSize) :
+    head(0),
+    tail(0),
+    wakeSize(0),
+    closed(false)
+{
+  size_t slots = 2;
+  while (slots < maxSize)
+    slots <<= 1;
+
+  mask = slots - 1;
+  buffer.reset(new Cell[slots]);
+  for (size_t i = 0; i < slots; ++i)
+    buffer[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+template <typename Datatype>
+Datatype RingQueue<Datatype>::Pop()
+{
+  const size_t pos = head.load(std::memory_order_relaxed);
+  Cell& cell = buffer[pos & mask];
+
+  // The slot may be claimed but not yet published by its producer.
+  while (cell.sequence.load(std::memory_order_acquire) != pos + 1)
+  {
+    if (tail.load(std::memory_order_acquire) == pos)
+    {
+      // The queue is empty; sleep until a producer claims the slot.
+      std::unique_lock<std::mutex> mlock(mutex_);
+      wakeSize.store(1);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      queueempty.wait(mlock, [this, pos]
+          { return tail.load(std::memory_order_acquire) != pos; });
+      wakeSize.store(0);
+    }
+    else
+    {
+      std::this_thread::yield();
+    }
+  }
+
+  Datatype item = std::move(cell.data);
+  cell.data = Datatype();
+
+  // Hand the slot back to the producers for the next lap.
+  cell.sequence.store(pos + mask + 1, std::memory_order_release);
+  head.store(pos + 1, std::memory_order_release);
+  return item;
+}
+
+template <typename Datatype>
+size_t RingQueue<Datatype>::PopBatch(const size_t n,
+                                     std::queue<Datatype>& items)
+{
+  const size_t pos = head.load(std::memory_order_relaxed);
+  size_t count = 0;
+  while (count < n)
+  {
+    Cell& cell = buffer[(pos + count) & mask];
+
+    // Stop at the first slot that isn't published yet.
+    if (cell.sequence.load(std::memory_order_acquire) != pos + count + 1)
+      break;
+
+    items.push(std::move(cell.data));
+    cell.data = Datatype();
+    cell.sequence.store(pos + count + mask + 1, std::memory_order_release);
+    ++count;
+  }
+
+  head.store(pos + count, std::memory_order_release);
+  return count;
+}
+
+template <typename Datatype>
+template <typename... Args>
+void RingQueue<Datatype>::Emplace(Args&&... args)
+{
+  size_t pos = tail.load(std::memory_order_relaxed);
+  Cell* cell;
+  while (true)
+  {
+    cell = &buffer[pos & mask];
+    const size_t seq = cell->sequence.load(std::memory_order_acquire);
+    const std::ptrdiff_t diff = (std::ptrdiff_t) seq - (std::ptrdiff_t) pos;
+    if (diff == 0)
+    {
+      // The slot is free; try to claim it.
+      if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        break;
+    }
+    else if (diff < 0)
+    {
+      // The queue is full; make sure the consumer is draining it.
+      Notify(mask + 1);
+      std::this_thread::yield();
+      pos = tail.load(std::memory_order_relaxed);
+    }
+    else
+    {
+      // Another producer claimed the slot first.
+      pos = tail.load(std::memory_order_relaxed);
+    }
+  }
+
+  cell->data = Datatype(std::forward<Args>(args)...);
+  cell->sequence.store(pos + 1, std::memory_order_release);
+  Notify(Size());
+}
+
+template <typename Datatype>
+template <typename Clock, typename Duration>
+void RingQueue<Datatype>::Wait(
+    const std::chrono::time_point<Clock, Duration>& deadline)
+{
+  std::unique_lock<std::mutex> mlock(mutex_);
+
+  // Sleep until there is something to consume.
+  wakeSize.store(1);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  queueempty.wait(mlock, [this] { return !Empty() || closed; });
+
+  // Give more elements a chance to arrive before the deadline, unless the
+  // producers would otherwise block on a full queue.
+  wakeSize.store(mask + 1);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  queueempty.wait_until(mlock, deadline, [this]
+      { return Size() > mask || closed; });
+  wakeSize.store(0);
+}
+
+template <typename Datatype>
+template <typename Clock, typename Duration>
+bool RingQueue<Datatype>::Wait(
+    const std::chrono::time_point<Clock, Duration>& deadline,
+    const std::chrono::time_point<Clock, Duration>& idleDeadline)
+{
+  std::unique_lock<std::mutex> mlock(mutex_);
+
+  wakeSize.store(1);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!queueempty.wait_until(mlock, idleDeadline, [this]
+      { return !Empty() || closed; }))
+  {
+    wakeSize.store(0);
+    return false;
+  }
+
+  wakeSize.store(mask + 1);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  queueempty.wait_until(mlock, deadline, [this]
+      { return Size() > mask || closed; });
+  wakeSize.store(0);
+  return true;
+}
+
+template <typename Datatype>
+void RingQueue<Datatype>::Close()
+{
+  {
+    std::lock_guard<std::mutex> mlock(mutex_);
+    closed = true;
+  }
+  queueempty.notify_all();
+}
+
+template <typename Datatype>
+void RingQueue<Datatype>::Notify(const size_t size)
+{
+  // Pairs with the fence in Wait(): either the consumer sees the new element,
+  // or the producer sees that the consumer is waiting.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  const size_t wanted = wakeSize.load(std::memory_order_relaxed);
+  if (wanted == 0 || size < wanted)
+    return;
+
+  // Taking the lock makes sure the consumer is either sleeping already or
+  // will see the element before it goes to sleep.
+  {
+    std::lock_guard<std::mutex> mlock(mutex_);
+  }
+  queueempty.notify_one();
+}
+
+} // namespace mlboard
+
+#endif
@@ -19,17 +19,98 @@ template <typename Datatype>
 class SharedQueue
 {
  public:
+  //! The type of the elements in the queue.
+  typedef Datatype ElemType;
+
+  /**
+   * Create an empty, open queue.
+   *
+   * @param maxSize The maximum number of elements in the queue.
+   */
+  SharedQueue(const size_t maxSize = 0) : maxSize(maxSize), closed(false) { }
+
   /**
    * Function to pop an element from the queue.
    */ 
   Datatype Pop();
 
   /**
-   * Function to push an element in the queue.
-   * 
+   * Function to move up to the given number of elements from the queue to the
+   * end of the given container, without waiting for new elements. If every
+   * pending element is requested and the container is empty, the contents are
+   * swapped in constant time.
+   *
+   * @param n The maximum number of elements to pop.
+   * @param items Container the elements are moved to.
+   * @return The number of elements popped.
+   */
+  size_t PopBatch(const size_t n, std::queue<Datatype>& items);
+
+  /**
+   * Function to move every pending element from the queue to the end of the
+   * given container, without waiting for new elements.
+   *
+   * @param items Container the elements are moved to.
+   * @return The number of elements popped.
+   */
+  size_t PopAll(std::queue<Datatype>& items)
+  {
+    return PopBatch(std::numeric_limits<size_t>::max(), items);
+  }
+
+  /**
+   * Function to push a copy of an element in the queue.
+   *
+   * @param item The element to be pushed.
+   */
+  void Push(const Datatype& item) { Emplace(item); }
+
+  /**
+   * Function to move an element into the queue.
+   *
    * @param item The element to be pushed.
    */
-  void Push(const Datatype& item);
+  void Push(Datatype&& item) { Emplace(std::move(item)); }
+
+  /**
+   * Function to construct an element in place at the end of the queue.
+   *
+   * @param args Arguments passed to the constructor of the element.
+   */
+  template<typename... Args>
+  void Emplace(Args&&... args);
+
+  /**
+   * Function to block the calling thread until there is something to be
+   * consumed. The thread sleeps until an element is pushed or the queue is
+   * closed; then it keeps sleeping until the given deadline passes, unless
+   * the queue fills up or is closed first.
+   *
+   * @param deadline Point in time until which pending elements can wait.
+   */
+  template<typename Clock, typename Duration>
+  void Wait(const std::chrono::time_point<Clock, Duration>& deadline);
+
+  /**
+   * An overload that stops waiting for a first element at the given idle
+   * deadline, so that the consumer can do its own periodic work while
+   * nothing is pushed.
+   *
+   * @param deadline Point in time until which pending elements can wait.
+   * @param idleDeadline Point in time at which the thread wakes up even if
+   *     nothing was pushed.
+   * @return False if the idle deadline passed without an element, true
+   *     otherwise.
+   */
+  template<typename Clock, typename Duration>
+  bool Wait(const std::chrono::time_point<Clock, Duration>& deadline,
+            const std::chrono::time_point<Clock, Duration>& idleDeadline);
+
+  /**
+   * Function to close the queue and wake up every waiting thread.
+   */
+  void Close();
+
   //! Get the size of the queue.
   size_t Size() const { return queue_.size(); }
   //! Get the maximum size of the queue.
@@ -38,6 +119,8 @@ class SharedQueue
   size_t& MaxSize() { return maxSize; }
   //! Check if queue is empty.
   bool Empty() { return queue_.empty(); }
+  //! Check if queue has been closed.
+  bool Closed() const { return closed; }
  private:
   //! Queue that holds the data being shared across threads.
   std::queue<Datatype> queue_;
@@ -55,6 +138,9 @@ class SharedQueue
 
   // Maximum number of elements that can be stored in queue during a time.
   std::size_t maxSize;
+
+  //! A flag that indicates that no more elements will be pushed.
+  std::atomic<bool> closed;
 };
 
 } // namespace mlboard
@@ -16,7 +16,7 @@ Datatype SharedQueue<Datatype>::Pop()
   {
     queueempty.wait(mlock);
   }
-  auto item = queue_.front();
+  Datatype item = std::move(queue_.front());
   queue_.pop();
   // Notify queueFull.
   mlock.unlock();
@@ -25,18 +25,86 @@ Datatype SharedQueue<Datatype>::Pop()
 }
 
 template <typename Datatype>
-void SharedQueue<Datatype>::Push(const Datatype& item)
+size_t SharedQueue<Datatype>::PopBatch(const size_t n,
+                                       std::queue<Datatype>& items)
+{
+  std::unique_lock<std::mutex> mlock(mutex_);
+  const size_t count = std::min(n, queue_.size());
+  if (count == queue_.size() && items.empty())
+  {
+    std::swap(queue_, items);
+  }
+  else
+  {
+    for (size_t i = 0; i < count; ++i)
+    {
+      items.push(std::move(queue_.front()));
+      queue_.pop();
+    }
+  }
+  // Notify queueFull once for the whole batch.
+  mlock.unlock();
+  if (count > 0)
+    queueFull.notify_all();
+  return count;
+}
+
+template <typename Datatype>
+template <typename... Args>
+void SharedQueue<Datatype>::Emplace(Args&&... args)
 {
   std::unique_lock<std::mutex> mlock(mutex_);
   while (queue_.size() >= maxSize)
   {
     queueFull.wait(mlock);
   }
-  queue_.push(item);
+  queue_.emplace(std::forward<Args>(args)...);
   mlock.unlock();
   queueempty.notify_all();
 }
 
+template <typename Datatype>
+template <typename Clock, typename Duration>
+void SharedQueue<Datatype>::Wait(
+    const std::chrono::time_point<Clock, Duration>& deadline)
+{
+  std::unique_lock<std::mutex> mlock(mutex_);
+  // Sleep until there is something to consume.
+  queueempty.wait(mlock, [this] { return !queue_.empty() || closed; });
+
+  // Give more elements a chance to arrive before the deadline, unless the
+  // producers would otherwise block on a full queue.
+  queueempty.wait_until(mlock, deadline, [this]
+      { return queue_.size() >= maxSize || closed; });
+}
+
+template <typename Datatype>
+template <typename Clock, typename Duration>
+bool SharedQueue<Datatype>::Wait(
+    const std::chrono::time_point<Clock, Duration>& deadline,
+    const std::chrono::time_point<Clock, Duration>& idleDeadline)
+{
+  std::unique_lock<std::mutex> mlock(mutex_);
+  if (!queueempty.wait_until(mlock, idleDeadline, [this]
+      { return !queue_.empty() || closed; }))
+    return false;
+
+  queueempty.wait_until(mlock, deadline, [this]
+      { return queue_.size() >= maxSize || closed; });
+  return true;
+}
+
+template <typename Datatype>
+void SharedQueue<Datatype>::Close()
+{
+  {
+    std::lock_guard<std::mutex> mlock(mutex_);
+    closed = true;
+  }
+  queueempty.notify_all();
+  queueFull.notify_all();
+}
+
 } // namespace mlboard
 
 #endif
@@ -8,6 +8,12 @@
 #include <mlboard/core.hpp>
 #include "filewriter.hpp"
 #include "util.hpp"
+#include "histogram.hpp"
+#include "quantilesketch.hpp"
+#include "prcurve.hpp"
+#include "png.hpp"
+#include "resize.hpp"
+#include "workerpool.hpp"
 #include <proto/summary.pb.h>
 #include <proto/projector_config.pb.h>
 #include <google/protobuf/text_format.h>
@@ -17,6 +23,16 @@ namespace mlboard {
 
 /**
  * Class responsible to create a summary to be logged.
+ *
+ * The asynchronous summaries, such as ImageAsync(), log their event when a
+ * thread of the pool is done with it. As the pool has many threads, these
+ * events can reach the event file out of step order, among themselves and
+ * with the summaries logged directly in the meantime. TensorBoard treats a
+ * step going backwards as a restart, and drops the points already read at
+ * later steps, unless it runs with --purge_orphaned_data=false. To keep the
+ * steps in order, wait for the future of a summary before logging a later
+ * step; a pool with a single thread keeps at least the asynchronous
+ * summaries logged through it in order.
  * 
  * @tparam filewriter The filewriter object which would convert it
  *    into events and then log to a file. 
@@ -142,20 +158,18 @@ class SummaryWriter
    * A overloaded function to create multiple image summary that is stored
    * in armadillo matrix (arma::mat).
    * 
-   * Please not that this function is very slow since the image has to be 
-   * processed and then converted to summary and hence this has to be run in
-   * seperate thread so that this function doesn't hinder any other operation.
-   * Also you can avoid creating a thread if logging time is not of concern for
-   * the application. Also make sure that all the images are of same height and
-   * width, since mlapck::load() function only supports loading images of same
-   * sizes.
+   * Every column of the matrix is an image in the layout of mlpack, and is
+   * encoded as a PNG in memory with util::EncodePNG(), so nothing is written
+   * to disk but the event. With OpenMP, the columns are encoded in
+   * parallel. The values are clamped to [0, 255]. It throws
+   * std::invalid_argument if the number of rows of the matrix isn't the
+   * width times the height times the channels of the image. If the channels
+   * are 0, they are the number of rows over the width and the height.
    * 
    * @param tag Tag to uniquely identify the image type.
    * @param step The step at which scalar was logged.
    * @param matrix Matrix which holds the information about images.
-   * @param height Height of image.
-   * @param width Width of image.
-   * @param channel Channel of image.
+   * @param info Width, height and channels of every image.
    * @param fw Filewriter object.
    * @param displayName Metadata for displaying Name of image.
    * @param desctiption Metadata for description of image.
@@ -163,12 +177,45 @@ class SummaryWriter
   template<typename eT>
   static void Image(const std::string& tag,
                     int step,
-                    arma::Mat<eT>& matrix,
-                    mlpack::data::ImageInfo& info,
+                    const arma::Mat<eT>& matrix,
+                    const mlpack::data::ImageInfo& info,
                     Filewriter& fw,
                     const std::string& displayName = "",
                     const std::string& description = "");
 
+  /**
+   * A overloaded function to create a thumbnail summary of every image of a
+   * matrix, for images that don't have to be seen at full size. Every image
+   * is shrunk to fit in maxWidth x maxHeight, keeping its aspect ratio, and
+   * quantized to 8 bits with util::ResizeImages() before it is encoded, so
+   * the event and the encoding scale with the size of the thumbnails.
+   * Images that fit already are only quantized. The channels and errors are
+   * the ones of the overload without thumbnails.
+   *
+   * @param tag Tag to uniquely identify the image type.
+   * @param step The step at which scalar was logged.
+   * @param matrix Matrix which holds the information about images.
+   * @param info Width, height and channels of every image.
+   * @param maxWidth Maximum width of the thumbnails, or 0 for no maximum.
+   * @param maxHeight Maximum height of the thumbnails, or 0 for no maximum.
+   * @param fw Filewriter object.
+   * @param filter Filter to shrink the images with.
+   * @param displayName Metadata for displaying Name of image.
+   * @param desctiption Metadata for description of image.
+   */
+  template<typename eT>
+  static void Image(const std::string& tag,
+                    int step,
+                    const arma::Mat<eT>& matrix,
+                    const mlpack::data::ImageInfo& info,
+                    const size_t maxWidth,
+                    const size_t maxHeight,
+                    Filewriter& fw,
+                    const util::ResizeFilter filter =
+                        util::ResizeFilter::Box,
+                    const std::string& displayName = "",
+                    const std::string& description = "");
+
   /**
    * A function to create histogram summary.
    * 
@@ -180,8 +227,8 @@ class SummaryWriter
    */
   static void Histogram(const std::string& tag,
                         int step,
-                        std::vector<double>& values,
-                        std::vector<double>& bins,
+                        const std::vector<double>& values,
+                        const std::vector<double>& bins,
                         Filewriter& fw);
 
   /**
@@ -195,12 +242,51 @@ class SummaryWriter
    */
   static void Histogram(const std::string& tag,
                         int step,
-                        std::vector<double>& values,
+                        const std::vector<double>& values,
+                        Filewriter& fw);
+
+  /**
+   * An overload function to create histogram summary of the values in
+   * memory, without copying them.
+   *
+   * @tparam eT Arithmetic type of the values.
+   * @param tag Tag to uniquely identify the histogram type.
+   * @param step The step at which the summary was logged.
+   * @param values Pointer to the values.
+   * @param n Number of values.
+   * @param bins The edges of the histogram.
+   * @param fw Filewriter object.
+   */
+  template<typename eT>
+  static void Histogram(const std::string& tag,
+                        int step,
+                        const eT* values,
+                        const size_t n,
+                        const std::vector<double>& bins,
+                        Filewriter& fw);
+
+  /**
+   * An overload function to create histogram summary of the values in
+   * memory, with default bins.
+   *
+   * @tparam eT Arithmetic type of the values.
+   * @param tag Tag to uniquely identify the histogram type.
+   * @param step The step at which the summary was logged.
+   * @param values Pointer to the values.
+   * @param n Number of values.
+   * @param fw Filewriter object.
+   */
+  template<typename eT>
+  static void Histogram(const std::string& tag,
+                        int step,
+                        const eT* values,
+                        const size_t n,
                         Filewriter& fw);
 
   /**
    * An overload function to create histogram summary, with
-   * support for arma::vec type.
+   * support for Armadillo matrices and vectors of any element type, such as
+   * arma::mat, arma::fmat or arma::rowvec. The values are not copied.
    * 
    * @param tag Tag to uniquely identify the histogram type.
    * @param step The step at which the summary was logged.
@@ -213,6 +299,67 @@ class SummaryWriter
                         const RowType& values,
                         Filewriter& fw);
 
+  /**
+   * An overload function to create histogram summary of an Armadillo
+   * subview, such as the columns of a matrix. The values are not copied.
+   *
+   * @param tag Tag to uniquely identify the histogram type.
+   * @param step The step at which the summary was logged.
+   * @param values Input data to compute histogram as arma::subview.
+   * @param fw Filewriter object.
+   */
+  template<typename eT>
+  static void Histogram(const std::string& tag,
+                        int step,
+                        const arma::subview<eT>& values,
+                        Filewriter& fw);
+
+  /**
+   * An overload function to create histogram summary of the values added to
+   * an accumulator, for example over an epoch.
+   *
+   * @param tag Tag to uniquely identify the histogram type.
+   * @param step The step at which the summary was logged.
+   * @param accumulator Accumulator holding the statistics of the values.
+   * @param fw Filewriter object.
+   */
+  static void Histogram(const std::string& tag,
+                        int step,
+                        const HistogramAccumulator& accumulator,
+                        Filewriter& fw);
+
+  /**
+   * An overload function to create histogram summary of the values added to
+   * a quantile sketch. The buckets of the sketch adapt to the values, and
+   * every non-empty bucket is written with its upper edge.
+   *
+   * @param tag Tag to uniquely identify the histogram type.
+   * @param step The step at which the summary was logged.
+   * @param sketch Sketch of the values.
+   * @param fw Filewriter object.
+   */
+  static void Histogram(const std::string& tag,
+                        int step,
+                        const QuantileSketch& sketch,
+                        Filewriter& fw);
+
+  /**
+   * An overload function to create histogram summary from statistics that
+   * were already computed.
+   *
+   * @param tag Tag to uniquely identify the histogram type.
+   * @param step The step at which the summary was logged.
+   * @param stats Statistics of the values.
+   * @param bins The edges of the histogram the statistics were computed
+   *     with.
+   * @param fw Filewriter object.
+   */
+  static void Histogram(const std::string& tag,
+                        int step,
+                        const util::HistogramStats& stats,
+                        const std::vector<double>& bins,
+                        Filewriter& fw);
+
    /**
    * A function to create a PR-Curve summary.
    * 
@@ -258,6 +405,313 @@ class SummaryWriter
                       vecType weights = {},
                       const std::string& displayName = "",
                       const std::string& description = "");
+
+  /**
+   * An overloaded function to create a PR-Curve summary of the labelled
+   * predictions added to an accumulator, for example over the batches of an
+   * evaluation set.
+   *
+   * @param tag Tag to uniquely identify the scalar type.
+   * @param step The step at which the summary was logged.
+   * @param accumulator Accumulator of the labelled predictions.
+   * @param fw Filewriter object.
+   * @param displayName Optional name for this summary.
+   * @param description Optional long-form description for this summary.
+   */
+  static void PRCurve(const std::string& tag,
+                      int step,
+                      const PRCurveAccumulator& accumulator,
+                      Filewriter& fw,
+                      const std::string& displayName = "",
+                      const std::string& description = "");
+
+  /**
+   * An overloaded function to create a PR-Curve summary from true and false
+   * positives that were already counted with util::PRCurveUpdate().
+   *
+   * @param tag Tag to uniquely identify the scalar type.
+   * @param step The step at which the summary was logged.
+   * @param counts Weighted true and false positives in every threshold
+   *    bucket.
+   * @param fw Filewriter object.
+   * @param displayName Optional name for this summary.
+   * @param description Optional long-form description for this summary.
+   */
+  static void PRCurve(const std::string& tag,
+                      int step,
+                      const util::PRCurveCounts& counts,
+                      Filewriter& fw,
+                      const std::string& displayName = "",
+                      const std::string& description = "");
+
+  /**
+   * A function to create the one-vs-rest PR-Curves of every class in a
+   * single event. The scores of all the classes are read in one pass, and
+   * the curve of every class is a summary value tagged tag/className.
+   *
+   * @param tag Tag to uniquely identify the scalar type.
+   * @param step The step at which the summary was logged.
+   * @param scores Matrix of predictions, with a row per class and a column
+   *    per point.
+   * @param labels Class of every point, either a row or a column vector.
+   * @param fw Filewriter object.
+   * @param threshold Number of thresholds.
+   * @param weights Optional weights of the points, Individual counts are
+   *    multiplied by this value.
+   * @param classNames Optional name of every class; the index of the class
+   *    by default.
+   * @param description Optional long-form description for this summary.
+   */
+  template<typename eT, typename LabelType>
+  static void PRCurve(const std::string& tag,
+                      int step,
+                      const arma::Mat<eT>& scores,
+                      const arma::Mat<LabelType>& labels,
+                      Filewriter& fw,
+                      int threshold = 127,
+                      const arma::Mat<eT>& weights = arma::Mat<eT>(),
+                      const std::vector<std::string>& classNames = {},
+                      const std::string& description = "");
+
+  /**
+   * An asynchronous version of the Image() overload of an image matrix. The
+   * images are encoded and logged by a thread of the pool, and the function
+   * returns at once. The matrix is shared with the caller, who mustn't
+   * modify it until the summary is logged. The returned future throws the
+   * exceptions of Image(). The file writer has to outlive the summary; wait
+   * for the future before closing it. The event can be logged out of step
+   * order; see the class documentation.
+   *
+   * @param tag Tag to uniquely identify the image type.
+   * @param step The step at which scalar was logged.
+   * @param matrix Matrix which holds the information about images.
+   * @param info Width, height and channels of every image.
+   * @param fw Filewriter object.
+   * @param displayName Metadata for displaying Name of image.
+   * @param desctiption Metadata for description of image.
+   * @param pool Pool of the thread logging the summary.
+   * @return Future that is ready once the summary is logged.
+   */
+  template<typename eT>
+  static std::future<void> ImageAsync(
+      const std::string& tag,
+      int step,
+      const std::shared_ptr<const arma::Mat<eT>>& matrix,
+      const mlpack::data::ImageInfo& info,
+      Filewriter& fw,
+      const std::string& displayName = "",
+      const std::string& description = "",
+      WorkerPool& pool = DefaultWorkerPool());
+
+  /**
+   * An overload of ImageAsync() that takes its own matrix, either a copy or,
+   * with std::move(), the matrix of the caller.
+   *
+   * @param tag Tag to uniquely identify the image type.
+   * @param step The step at which scalar was logged.
+   * @param matrix Matrix which holds the information about images.
+   * @param info Width, height and channels of every image.
+   * @param fw Filewriter object.
+   * @param displayName Metadata for displaying Name of image.
+   * @param desctiption Metadata for description of image.
+   * @param pool Pool of the thread logging the summary.
+   * @return Future that is ready once the summary is logged.
+   */
+  template<typename eT>
+  static std::future<void> ImageAsync(const std::string& tag,
+                                      int step,
+                                      arma::Mat<eT> matrix,
+                                      const mlpack::data::ImageInfo& info,
+                                      Filewriter& fw,
+                                      const std::string& displayName = "",
+                                      const std::string& description = "",
+                                      WorkerPool& pool = DefaultWorkerPool());
+
+  /**
+   * An asynchronous version of the Embedding() overload of arma::mat. The
+   * tensor and metadata files are written and the summary is logged by a
+   * thread of the pool, and the function returns at once. The matrix is
+   * shared with the caller, who mustn't modify it until the summary is
+   * logged. The returned future throws the exceptions of Embedding(). The
+   * file writer has to outlive the summary; wait for the future before
+   * closing it. The event can be logged out of step order; see the class
+   * documentation.
+   *
+   * @param tensorName Name of the tensor to identify it.
+   * @param tensorData Matrix having the data.
+   * @param metadata Metadata of every column of the matrix.
+   * @param fw Filewriter object.
+   * @param tensordataPath Path of the file to store data (currently
+   *    only support .tsv format).
+   * @param metadataPath Path of the file to store metadata information
+   *    about the tensor.
+   * @param relativeTensorDataPath Relative Path from Log directory
+   *    of the file to store data.
+   * @param relativeMetadataPath Relative Path from Log directory
+   *    the file to store metadata information about the tensor.
+   * @param pool Pool of the thread logging the summary.
+   * @return Future that is ready once the summary is logged.
+   */
+  static std::future<void> EmbeddingAsync(
+      const std::string& tensorName,
+      const std::shared_ptr<const arma::mat>& tensorData,
+      std::vector<std::string> metadata,
+      Filewriter& fw,
+      const std::string& tensordataPath = "",
+      const std::string& metadataPath = "",
+      const std::string& relativeTensordataPath = "",
+      const std::string& relativeMetadataPath = "",
+      WorkerPool& pool = DefaultWorkerPool());
+
+  /**
+   * An overload of EmbeddingAsync() that takes its own matrix, either a copy
+   * or, with std::move(), the matrix of the caller.
+   *
+   * @param tensorName Name of the tensor to identify it.
+   * @param tensorData Matrix having the data.
+   * @param metadata Metadata of every column of the matrix.
+   * @param fw Filewriter object.
+   * @param tensordataPath Path of the file to store data (currently
+   *    only support .tsv format).
+   * @param metadataPath Path of the file to store metadata information
+   *    about the tensor.
+   * @param relativeTensorDataPath Relative Path from Log directory
+   *    of the file to store data.
+   * @param relativeMetadataPath Relative Path from Log directory
+   *    the file to store metadata information about the tensor.
+   * @param pool Pool of the thread logging the summary.
+   * @return Future that is ready once the summary is logged.
+   */
+  static std::future<void> EmbeddingAsync(
+      const std::string& tensorName,
+      arma::mat tensorData,
+      std::vector<std::string> metadata,
+      Filewriter& fw,
+      const std::string& tensordataPath = "",
+      const std::string& metadataPath = "",
+      const std::string& relativeTensordataPath = "",
+      const std::string& relativeMetadataPath = "",
+      WorkerPool& pool = DefaultWorkerPool());
+
+  /**
+   * An asynchronous version of the PRCurve() overload of std::vector. The
+   * curve is computed and logged by a thread of the pool, and the function
+   * returns at once. The vectors are copied, or moved with std::move(). The
+   * file writer has to outlive the summary; wait for the future before
+   * closing it. The event can be logged out of step order; see the class
+   * documentation.
+   *
+   * @param tag Tag to uniquely identify the scalar type.
+   * @param labels Vector of ground truth values.
+   * @param predictions Vector of predictions.
+   * @param fw Filewriter object.
+   * @param threshold Number of thresholds.
+   * @param weights Vector having the weights of labels,
+   *    Individual counts are multiplied by this value.
+   * @param displayName Optional name for this summary.
+   * @param description Optional long-form description for this summary.
+   * @param pool Pool of the thread logging the summary.
+   * @return Future that is ready once the summary is logged.
+   */
+  static std::future<void> PRCurveAsync(
+      const std::string& tag,
+      std::vector<double> labels,
+      std::vector<double> predictions,
+      Filewriter& fw,
+      int threshold = 127,
+      std::vector<double> weights = {},
+      const std::string& displayName = "",
+      const std::string& description = "",
+      WorkerPool& pool = DefaultWorkerPool());
+
+  /**
+   * An asynchronous version of the PRCurve() overload of the one-vs-rest
+   * curves of every class. The curves are computed and logged by a thread of
+   * the pool, and the function returns at once. The matrices are copied, or
+   * moved with std::move(). The file writer has to outlive the summary; wait
+   * for the future before closing it. The event can be logged out of step
+   * order; see the class documentation.
+   *
+   * @param tag Tag to uniquely identify the scalar type.
+   * @param step The step at which the summary was logged.
+   * @param scores Matrix of predictions, with a row per class and a column
+   *    per point.
+   * @param labels Class of every point, either a row or a column vector.
+   * @param fw Filewriter object.
+   * @param threshold Number of thresholds.
+   * @param weights Optional weights of the points, Individual counts are
+   *    multiplied by this value.
+   * @param classNames Optional name of every class; the index of the class
+   *    by default.
+   * @param description Optional long-form description for this summary.
+   * @param pool Pool of the thread logging the summary.
+   * @return Future that is ready once the summary is logged.
+   */
+  template<typename eT, typename LabelType>
+  static std::future<void> PRCurveAsync(
+      const std::string& tag,
+      int step,
+      arma::Mat<eT> scores,
+      arma::Mat<LabelType> labels,
+      Filewriter& fw,
+      int threshold = 127,
+      arma::Mat<eT> weights = arma::Mat<eT>(),
+      std::vector<std::string> classNames = {},
+      const std::string& description = "",
+      WorkerPool& pool = DefaultWorkerPool());
+
+ private:
+  /**
+   * Create the summary of an event with the NewSummary() of the file writer,
+   * which can allocate it on an arena, if it has one.
+   *
+   * @param fw Filewriter object.
+   * @return Summary that is passed to the CreateEvent() of the file writer.
+   */
+  template<typename WriterType>
+  static auto NewSummary(WriterType& fw, int) -> decltype(fw.NewSummary())
+  { return fw.NewSummary(); }
+
+  /**
+   * Create the summary of an event on the heap, for file writers without
+   * NewSummary(), which only need CreateEvent().
+   *
+   * @param fw Filewriter object.
+   * @return Summary that is passed to the CreateEvent() of the file writer.
+   */
+  template<typename WriterType>
+  static mlboard::Summary* NewSummary(WriterType& /* fw */, long)
+  { return new mlboard::Summary(); }
+
+  /**
+   * Add the PR-Curve of the given counts to a summary.
+   *
+   * @param summary Summary the value is added to.
+   * @param tag Tag to uniquely identify the scalar type.
+   * @param counts Weighted true and false positives in every threshold
+   *    bucket.
+   * @param displayName Name for this summary; the tag if it is empty.
+   * @param description Long-form description for this summary.
+   */
+  static void PRCurveValue(mlboard::Summary* summary,
+                           const std::string& tag,
+                           const util::PRCurveCounts& counts,
+                           const std::string& displayName,
+                           const std::string& description);
+
+  /**
+   * Get the number of channels of the images in a matrix. If the channels of
+   * the image info are 0, they are the number of rows over the width and the
+   * height. It throws std::invalid_argument if the number of rows of the
+   * matrix isn't the width times the height times the channels.
+   *
+   * @param matrix Matrix with an image in every column.
+   * @param info Width, height and channels of every image.
+   * @return Channels of every image.
+   */
+  template<typename eT>
+  static size_t ImageChannels(const arma::Mat<eT>& matrix,
+                              const mlpack::data::ImageInfo& info);
 };
 
 } // namespace mlboard
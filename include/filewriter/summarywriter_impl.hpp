@@ -16,7 +16,7 @@ void SummaryWriter<Filewriter>::Scalar(const std::string& tag,
                                        double value,
                                        Filewriter& fw)
 {
-  mlboard::Summary *summary = new Summary();
+  mlboard::Summary *summary = NewSummary(fw, 0);
   mlboard::Summary_Value *v = summary->add_value();
   v->set_tag(tag);
   v->set_simple_value(value);
@@ -29,24 +29,18 @@ void SummaryWriter<Filewriter>::Text(const std::string &tag,
                                      const std::string& text,
                                      Filewriter& fw)
 {
-  mlboard::SummaryMetadata_PluginData *pluginData =
-      new SummaryMetadata::PluginData();
-  pluginData->set_plugin_name("text");
+  mlboard::Summary *summary = NewSummary(fw, 0);
+  mlboard::Summary_Value *v = summary->add_value();
+  v->set_tag(tag);
 
-  mlboard::SummaryMetadata *meta = new SummaryMetadata();
-  meta->set_allocated_plugin_data(pluginData);
+  mlboard::SummaryMetadata *meta = v->mutable_metadata();
+  meta->mutable_plugin_data()->set_plugin_name("text");
 
-  mlboard::TensorProto *tensor = new TensorProto();
+  mlboard::TensorProto *tensor = v->mutable_tensor();
   tensor->set_dtype(mlboard::DataType::DT_STRING);
 
   tensor->add_string_val(text);
 
-  mlboard::Summary *summary = new Summary();
-  mlboard::Summary_Value *v = summary->add_value();
-  v->set_tag(tag);
-  v->set_allocated_tensor(tensor);
-  v->set_allocated_metadata(meta);
-
   fw.CreateEvent(step, summary);
 }
 
@@ -61,22 +55,20 @@ void SummaryWriter<Filewriter>::Image(const std::string& tag,
                                       const std::string& displayName,
                                       const std::string& description)
 {
-  mlboard::SummaryMetadata *meta = new SummaryMetadata();
+  mlboard::Summary *summary = NewSummary(fw, 0);
+  mlboard::Summary_Value *v = summary->add_value();
+  v->set_tag(tag);
+
+  mlboard::SummaryMetadata *meta = v->mutable_metadata();
   meta->set_display_name(displayName == "" ? tag : displayName);
   meta->set_summary_description(description);
 
-  mlboard::Summary_Image *image = new Summary::Image();
+  mlboard::Summary_Image *image = v->mutable_image();
   image->set_height(height);
   image->set_width(width);
   image->set_colorspace(channel);
   image->set_encoded_image_string(encodedImage);
 
-  mlboard::Summary *summary = new Summary();
-  mlboard::Summary_Value *v = summary->add_value();
-  v->set_tag(tag);
-  v->set_allocated_image(image);
-  v->set_allocated_metadata(meta);
-
   fw.CreateEvent(step, summary);
 }
 
@@ -91,26 +83,22 @@ void SummaryWriter<Filewriter>::Image(
     const std::string& displayName,
     const std::string& description)
 {
-  mlboard::SummaryMetadata_PluginData *pluginData =
-    new SummaryMetadata::PluginData();
-  pluginData->set_plugin_name("images");
-  mlboard::SummaryMetadata *meta = new SummaryMetadata();
+  mlboard::Summary *summary = NewSummary(fw, 0);
+  mlboard::Summary_Value *v = summary->add_value();
+  v->set_tag(tag);
+
+  mlboard::SummaryMetadata *meta = v->mutable_metadata();
   meta->set_display_name(displayName == "" ? tag : displayName);
   meta->set_summary_description(description);
-  meta->set_allocated_plugin_data(pluginData);
+  meta->mutable_plugin_data()->set_plugin_name("images");
 
-  mlboard::TensorProto *tensor = new TensorProto();
+  mlboard::TensorProto *tensor = v->mutable_tensor();
   tensor->set_dtype(mlboard::DataType::DT_STRING);
   tensor->add_string_val(std::to_string(width));
   tensor->add_string_val(std::to_string(height));
   for (const std::string& image : encodedImages)
       tensor->add_string_val(image);
 
-  mlboard::Summary *summary = new Summary();
-  mlboard::Summary_Value *v = summary->add_value();
-  v->set_tag(tag);
-  v->set_allocated_tensor(tensor);
-  v->set_allocated_metadata(meta);
   fw.CreateEvent(step, summary);
 }
 
@@ -118,113 +106,92 @@ template<typename Filewriter>
 template<typename eT>
 void SummaryWriter<Filewriter>::Image(const std::string& tag,
                 int step,
-                arma::Mat<eT>& matrix,
-                mlpack::data::ImageInfo& info,
+                const arma::Mat<eT>& matrix,
+                const mlpack::data::ImageInfo& info,
                 Filewriter& fw,
                 const std::string& displayName,
                 const std::string& description)
 {
-  // Create a temp directory.
-  int check;
-  #if defined(_WIN32)
-    check = mkdir("_preprocess_");
-  #else
-    check = mkdir("_preprocess_", 0777);
-  #endif
-
-  // Create a vector of temp file names.
-  std::vector<std::string> fileNames(matrix.n_cols);
-  for (size_t i = 0; i < matrix.n_cols; i++)
-    fileNames[i] = "_preprocess_/"+std::to_string(i)+".png";
-
-  mlpack::data::Save(fileNames, matrix, info, false);
-
+  const size_t channels = ImageChannels(matrix, info);
   std::vector<std::string> encodedImages;
-  mlboard::util::EncodeImage(fileNames, encodedImages);
+  mlboard::util::EncodePNG(matrix, info.Width(), info.Height(), channels,
+      encodedImages);
 
   Image(tag, step, encodedImages, info.Height(),
     info.Width(), fw, displayName, description);
+}
+
+template<typename Filewriter>
+template<typename eT>
+void SummaryWriter<Filewriter>::Image(
+    const std::string& tag,
+    int step,
+    const arma::Mat<eT>& matrix,
+    const mlpack::data::ImageInfo& info,
+    const size_t maxWidth,
+    const size_t maxHeight,
+    Filewriter& fw,
+    const util::ResizeFilter filter,
+    const std::string& displayName,
+    const std::string& description)
+{
+  const size_t channels = ImageChannels(matrix, info);
+  size_t width, height;
+  util::ThumbnailSize(info.Width(), info.Height(), maxWidth, maxHeight,
+      width, height);
+
+  arma::Mat<unsigned char> thumbnails;
+  util::ResizeImages(matrix, info.Width(), info.Height(), channels, width,
+      height, filter, thumbnails);
+  std::vector<std::string> encodedImages;
+  util::EncodePNG(thumbnails, width, height, channels, encodedImages);
 
-  // Remove all the files.
-  for (size_t i = 0; i < matrix.n_cols; i++)
-    remove(fileNames[i].c_str());
+  Image(tag, step, encodedImages, height, width, fw, displayName,
+      description);
 }
 
 template<typename Filewriter>
 void SummaryWriter<Filewriter>::Histogram(const std::string& tag,
                                           int step,
-                                          std::vector<double>& values,
-                                          std::vector<double>& bins,
+                                          const std::vector<double>& values,
+                                          const std::vector<double>& bins,
                                           Filewriter& fw)
 {
-  size_t num = values.size();
-  double min = std::numeric_limits<double>::max();
-  double max = std::numeric_limits<double>::lowest();
-  double sum = 0.0;
-  double sumofSquares = 0.0;
-
-  std::vector<int> counts(bins.size(), 0);
-  for (size_t i = 0; i < num; ++i)
-  {
-    float v = values[i];
-    auto lb = lower_bound(bins.begin(), bins.end(), v);
-    counts[lb - bins.begin()]++;
-    sum += v;
-    sumofSquares += v * v;
-    if (v > max)
-    {
-      max = v;
-    }
-    else if (v < min)
-    {
-      min = v;
-    }
-  }
+  Histogram(tag, step, values.data(), values.size(), bins, fw);
+}
 
-  mlboard::HistogramProto *histo = new HistogramProto();
-  histo->set_min(min);
-  histo->set_max(max);
-  histo->set_num(num);
-  histo->set_sum(sum);
-  histo->set_sum_squares(sumofSquares);
-  for (size_t i = 0; i < counts.size(); ++i)
-  {
-    if (counts[i] > 0)
-    {
-      histo->add_bucket_limit(bins[i]);
-      histo->add_bucket(counts[i]);
-    }
-  }
-  mlboard::Summary *summary = new Summary();
-  mlboard::Summary_Value *v = summary->add_value();
-  v->set_tag(tag);
-  v->set_allocated_histo(histo);
-  fw.CreateEvent(step, summary);
+template<typename Filewriter>
+void SummaryWriter<Filewriter>::Histogram(const std::string& tag,
+                                          int step,
+                                          const std::vector<double>& values,
+                                          Filewriter& fw)
+{
+  Histogram(tag, step, values, util::DefaultHistogramEdges(), fw);
 }
 
 template<typename Filewriter>
+template<typename eT>
 void SummaryWriter<Filewriter>::Histogram(const std::string& tag,
                                           int step,
-                                          std::vector<double>& values,
+                                          const eT* values,
+                                          const size_t n,
+                                          const std::vector<double>& bins,
                                           Filewriter& fw)
 {
-  std::vector<double> edges;
-  std::vector<double> posEdges, negEdges;
-  double v = 1e-12;
-  while (v < 1e20)
-  {
-    posEdges.push_back(v);
-    negEdges.push_back(-v);
-    v *= 1.1;
-  }
-  posEdges.push_back(std::numeric_limits<double>::max());
-  negEdges.push_back(std::numeric_limits<double>::lowest());
-
-  edges.insert(edges.end(), negEdges.rbegin(),
-      negEdges.rend());
-  edges.insert(edges.end(), posEdges.begin(),
-      posEdges.end());
-  Histogram(tag, step, values, edges, fw);
+  util::HistogramStats stats(bins.size());
+  util::HistogramUpdate(values, n, bins, stats);
+  Histogram(tag, step, stats, bins, fw);
+}
+
+template<typename Filewriter>
+template<typename eT>
+void SummaryWriter<Filewriter>::Histogram(const std::string& tag,
+                                          int step,
+                                          const eT* values,
+                                          const size_t n,
+                                          Filewriter& fw)
+{
+  Histogram(tag, step, values, n, util::DefaultHistogramEdges(), fw);
 }
 
 template<typename Filewriter>
@@ -234,9 +201,85 @@ void SummaryWriter<Filewriter>::Histogram(const std::string& tag,
                                           const RowType& values,
                                           Filewriter& fw)
 {
-  std::vector<double>tempValues(values.memptr(),
-      values.memptr() + values.n_elem);
-  Histogram(tag, step, tempValues, fw);
+  Histogram(tag, step, values.memptr(), values.n_elem, fw);
+}
+
+template<typename Filewriter>
+template<typename eT>
+void SummaryWriter<Filewriter>::Histogram(const std::string& tag,
+                                          int step,
+                                          const arma::subview<eT>& values,
+                                          Filewriter& fw)
+{
+  HistogramAccumulator accumulator;
+  accumulator.Add(values);
+  Histogram(tag, step, accumulator, fw);
+}
+
+template<typename Filewriter>
+void SummaryWriter<Filewriter>::Histogram(
+    const std::string& tag,
+    int step,
+    const HistogramAccumulator& accumulator,
+    Filewriter& fw)
+{
+  Histogram(tag, step, accumulator.Stats(), accumulator.Bins(), fw);
+}
+
+template<typename Filewriter>
+void SummaryWriter<Filewriter>::Histogram(const std::string& tag,
+                                          int step,
+                                          const QuantileSketch& sketch,
+                                          Filewriter& fw)
+{
+  std::vector<double> limits, counts;
+  sketch.Buckets(limits, counts);
+
+  mlboard::Summary *summary = NewSummary(fw, 0);
+  mlboard::Summary_Value *v = summary->add_value();
+  v->set_tag(tag);
+
+  mlboard::HistogramProto *histo = v->mutable_histo();
+  histo->set_min(sketch.Min());
+  histo->set_max(sketch.Max());
+  histo->set_num(sketch.Num());
+  histo->set_sum(sketch.Sum());
+  histo->set_sum_squares(sketch.SumSquares());
+  for (size_t i = 0; i < limits.size(); ++i)
+  {
+    histo->add_bucket_limit(limits[i]);
+    histo->add_bucket(counts[i]);
+  }
+  fw.CreateEvent(step, summary);
+}
+
+template<typename Filewriter>
+void SummaryWriter<Filewriter>::Histogram(const std::string& tag,
+                                          int step,
+                                          const util::HistogramStats& stats,
+                                          const std::vector<double>& bins,
+                                          Filewriter& fw)
+{
+  mlboard::Summary *summary = NewSummary(fw, 0);
+  mlboard::Summary_Value *v = summary->add_value();
+  v->set_tag(tag);
+
+  mlboard::HistogramProto *histo = v->mutable_histo();
+  histo->set_min(stats.Min());
+  histo->set_max(stats.Max());
+  histo->set_num(stats.Num());
+  histo->set_sum(stats.Sum());
+  histo->set_sum_squares(stats.SumSquares());
+  const std::vector<size_t>& counts = stats.Counts();
+  for (size_t i = 0; i < counts.size(); ++i)
+  {
+    if (counts[i] > 0)
+    {
+      histo->add_bucket_limit(bins[i]);
+      histo->add_bucket(counts[i]);
+    }
+  }
+  fw.CreateEvent(step, summary);
 }
 
 template<typename Filewriter>
@@ -247,14 +290,13 @@ void SummaryWriter<Filewriter>::Embedding(
     const std::string& metadataPath,
     const std::vector<size_t>& tensorShape)
 {
-  mlboard::SummaryMetadata_PluginData *pluginData =
-      new SummaryMetadata::PluginData();
-  pluginData->set_plugin_name("projector");
-  mlboard::SummaryMetadata *metadata = new SummaryMetadata();
-  metadata->set_allocated_plugin_data(pluginData);
-
   const std::string &filename = fw.LogDir() + "/projector_config.pbtxt";;
-  mlboard::ProjectorConfig *config = new ProjectorConfig();
+  mlboard::ProjectorConfig config;
+
+  // The config file is read and written back whole, so embeddings logged at
+  // the same time, such as by EmbeddingAsync(), take turns.
+  static std::mutex configMutex;
+  std::unique_lock<std::mutex> configLock(configMutex);
 
   // Parse possibly existing config file.
   std::ifstream fin(filename);
@@ -262,11 +304,11 @@ void SummaryWriter<Filewriter>::Embedding(
   {
     std::ostringstream ss;
     ss << fin.rdbuf();
-    google::protobuf::TextFormat::ParseFromString(ss.str(), config);
+    google::protobuf::TextFormat::ParseFromString(ss.str(), &config);
     fin.close();
   }
 
-  mlboard::EmbeddingInfo *embedding = config->add_embeddings();
+  mlboard::EmbeddingInfo *embedding = config.add_embeddings();
   embedding->set_tensor_name(tensorName);
   embedding->set_tensor_path(tensordataPath);
   if (metadataPath != "")
@@ -278,18 +320,19 @@ void SummaryWriter<Filewriter>::Embedding(
     for (size_t shape : tensorShape) embedding->add_tensor_shape(shape);
   }
 
-  // The `config` and `embedding` pointers will be deleted by the
-  // ProjectorConfig destructor.
+  // The `embedding` pointer will be deleted by the ProjectorConfig
+  // destructor.
   std::ofstream fout(filename);
   std::string content;
-  google::protobuf::TextFormat::PrintToString(*config, &content);
+  google::protobuf::TextFormat::PrintToString(config, &content);
   fout << content;
   fout.close();
+  configLock.unlock();
 
-  mlboard::Summary *summary = new Summary();
+  mlboard::Summary *summary = NewSummary(fw, 0);
   mlboard::Summary_Value *v = summary->add_value();
   v->set_tag("embedding");
-  v->set_allocated_metadata(metadata);
+  v->mutable_metadata()->mutable_plugin_data()->set_plugin_name("projector");
 
   fw.CreateEvent(1, summary);
 }
@@ -369,52 +412,263 @@ void SummaryWriter<Filewriter>::PRCurve(const std::string& tag,
                                         std::vector<double>weights,
                                         const std::string& displayName,
                                         const std::string& description)
+{
+  PRCurveAccumulator accumulator((std::max)(threshold, 0));
+  accumulator.Add(labels, predictions, weights);
+  PRCurve(tag, 0, accumulator, fw, displayName, description);
+}
+
+template<typename Filewriter>
+template<typename vecType>
+void SummaryWriter<Filewriter>::PRCurve(const std::string& tag,
+                                        const vecType& labels,
+                                        const vecType& predictions,
+                                        Filewriter& fw,
+                                        int threshold,
+                                        vecType weights,
+                                        const std::string& displayName,
+                                        const std::string& description)
+{
+  PRCurveAccumulator accumulator((std::max)(threshold, 0));
+  accumulator.Add(labels, predictions, weights);
+  PRCurve(tag, 0, accumulator, fw, displayName, description);
+}
+
+template<typename Filewriter>
+void SummaryWriter<Filewriter>::PRCurve(
+    const std::string& tag,
+    int step,
+    const PRCurveAccumulator& accumulator,
+    Filewriter& fw,
+    const std::string& displayName,
+    const std::string& description)
+{
+  PRCurve(tag, step, accumulator.Counts(), fw, displayName, description);
+}
+
+template<typename Filewriter>
+void SummaryWriter<Filewriter>::PRCurve(const std::string& tag,
+                                        int step,
+                                        const util::PRCurveCounts& counts,
+                                        Filewriter& fw,
+                                        const std::string& displayName,
+                                        const std::string& description)
+{
+  mlboard::Summary *summary = NewSummary(fw, 0);
+  PRCurveValue(summary, tag, counts, displayName, description);
+  fw.CreateEvent(step, summary);
+}
+
+template<typename Filewriter>
+template<typename eT, typename LabelType>
+void SummaryWriter<Filewriter>::PRCurve(
+    const std::string& tag,
+    int step,
+    const arma::Mat<eT>& scores,
+    const arma::Mat<LabelType>& labels,
+    Filewriter& fw,
+    int threshold,
+    const arma::Mat<eT>& weights,
+    const std::vector<std::string>& classNames,
+    const std::string& description)
+{
+  const size_t n = (std::min)((size_t) scores.n_cols, (size_t) labels.n_elem);
+  const eT* weightsPtr = nullptr;
+  std::vector<eT> paddedWeights;
+  if (weights.n_elem >= n && weights.n_elem > 0)
+  {
+    weightsPtr = weights.memptr();
+  }
+  else if (weights.n_elem > 0)
+  {
+    paddedWeights.assign(n, 1);
+    std::copy(weights.memptr(), weights.memptr() + weights.n_elem,
+        paddedWeights.begin());
+    weightsPtr = paddedWeights.data();
+  }
+
+  std::vector<util::PRCurveCounts> counts(scores.n_rows,
+      util::PRCurveCounts((std::max)(threshold, 0)));
+  util::MultiClassPRCurveUpdate(scores.memptr(), labels.memptr(), weightsPtr,
+      n, counts);
+
+  mlboard::Summary *summary = NewSummary(fw, 0);
+  for (size_t c = 0; c < counts.size(); ++c)
+  {
+    const std::string className = c < classNames.size() ? classNames[c] :
+        std::to_string(c);
+    PRCurveValue(summary, tag + "/" + className, counts[c], className,
+        description);
+  }
+  fw.CreateEvent(step, summary);
+}
+
+template<typename Filewriter>
+template<typename eT>
+std::future<void> SummaryWriter<Filewriter>::ImageAsync(
+    const std::string& tag,
+    int step,
+    const std::shared_ptr<const arma::Mat<eT>>& matrix,
+    const mlpack::data::ImageInfo& info,
+    Filewriter& fw,
+    const std::string& displayName,
+    const std::string& description,
+    WorkerPool& pool)
+{
+  Filewriter* writer = &fw;
+  return pool.Submit([=]()
+  {
+    Image(tag, step, *matrix, info, *writer, displayName, description);
+  });
+}
+
+template<typename Filewriter>
+template<typename eT>
+std::future<void> SummaryWriter<Filewriter>::ImageAsync(
+    const std::string& tag,
+    int step,
+    arma::Mat<eT> matrix,
+    const mlpack::data::ImageInfo& info,
+    Filewriter& fw,
+    const std::string& displayName,
+    const std::string& description,
+    WorkerPool& pool)
+{
+  return ImageAsync(tag, step, std::shared_ptr<const arma::Mat<eT>>(
+      std::make_shared<arma::Mat<eT>>(std::move(matrix))), info, fw,
+      displayName, description, pool);
+}
+
+template<typename Filewriter>
+std::future<void> SummaryWriter<Filewriter>::EmbeddingAsync(
+    const std::string& tensorName,
+    const std::shared_ptr<const arma::mat>& tensorData,
+    std::vector<std::string> metadata,
+    Filewriter& fw,
+    const std::string& tensordataPath,
+    const std::string& metadataPath,
+    const std::string& relativeTensordataPath,
+    const std::string& relativeMetadataPath,
+    WorkerPool& pool)
+{
+  // The lambda can't move the metadata in C++11, so it shares it too.
+  std::shared_ptr<const std::vector<std::string>> sharedMetadata =
+      std::make_shared<std::vector<std::string>>(std::move(metadata));
+  Filewriter* writer = &fw;
+  return pool.Submit([=]()
+  {
+    Embedding(tensorName, *tensorData, *sharedMetadata, *writer,
+        tensordataPath, metadataPath, relativeTensordataPath,
+        relativeMetadataPath);
+  });
+}
+
+template<typename Filewriter>
+std::future<void> SummaryWriter<Filewriter>::EmbeddingAsync(
+    const std::string& tensorName,
+    arma::mat tensorData,
+    std::vector<std::string> metadata,
+    Filewriter& fw,
+    const std::string& tensordataPath,
+    const std::string& metadataPath,
+    const std::string& relativeTensordataPath,
+    const std::string& relativeMetadataPath,
+    WorkerPool& pool)
+{
+  return EmbeddingAsync(tensorName, std::shared_ptr<const arma::mat>(
+      std::make_shared<arma::mat>(std::move(tensorData))),
+      std::move(metadata), fw, tensordataPath, metadataPath,
+      relativeTensordataPath, relativeMetadataPath, pool);
+}
+
+template<typename Filewriter>
+std::future<void> SummaryWriter<Filewriter>::PRCurveAsync(
+    const std::string& tag,
+    std::vector<double> labels,
+    std::vector<double> predictions,
+    Filewriter& fw,
+    int threshold,
+    std::vector<double> weights,
+    const std::string& displayName,
+    const std::string& description,
+    WorkerPool& pool)
+{
+  typedef std::vector<double> VecType;
+  std::shared_ptr<const VecType> sharedLabels =
+      std::make_shared<VecType>(std::move(labels));
+  std::shared_ptr<const VecType> sharedPredictions =
+      std::make_shared<VecType>(std::move(predictions));
+  std::shared_ptr<const VecType> sharedWeights =
+      std::make_shared<VecType>(std::move(weights));
+  Filewriter* writer = &fw;
+  return pool.Submit([=]()
+  {
+    PRCurve(tag, *sharedLabels, *sharedPredictions, *writer, threshold,
+        *sharedWeights, displayName, description);
+  });
+}
+
+template<typename Filewriter>
+template<typename eT, typename LabelType>
+std::future<void> SummaryWriter<Filewriter>::PRCurveAsync(
+    const std::string& tag,
+    int step,
+    arma::Mat<eT> scores,
+    arma::Mat<LabelType> labels,
+    Filewriter& fw,
+    int threshold,
+    arma::Mat<eT> weights,
+    std::vector<std::string> classNames,
+    const std::string& description,
+    WorkerPool& pool)
+{
+  std::shared_ptr<const arma::Mat<eT>> sharedScores =
+      std::make_shared<arma::Mat<eT>>(std::move(scores));
+  std::shared_ptr<const arma::Mat<LabelType>> sharedLabels =
+      std::make_shared<arma::Mat<LabelType>>(std::move(labels));
+  std::shared_ptr<const arma::Mat<eT>> sharedWeights =
+      std::make_shared<arma::Mat<eT>>(std::move(weights));
+  std::shared_ptr<const std::vector<std::string>> sharedClassNames =
+      std::make_shared<std::vector<std::string>>(std::move(classNames));
+  Filewriter* writer = &fw;
+  return pool.Submit([=]()
+  {
+    PRCurve(tag, step, *sharedScores, *sharedLabels, *writer, threshold,
+        *sharedWeights, *sharedClassNames, description);
+  });
+}
+
+template<typename Filewriter>
+void SummaryWriter<Filewriter>::PRCurveValue(
+    mlboard::Summary* summary,
+    const std::string& tag,
+    const util::PRCurveCounts& counts,
+    const std::string& displayName,
+    const std::string& description)
 {
   // PR-Curve plugin.
-  mlboard::PrCurvePluginData *prCurvePlugin = new PrCurvePluginData();
-  prCurvePlugin->set_version(0);
-  prCurvePlugin->set_num_thresholds(threshold);
-  std::string prCurveContent;
-  prCurvePlugin->SerializeToString(&prCurveContent);
+  mlboard::PrCurvePluginData prCurvePlugin;
+  prCurvePlugin.set_version(0);
+  prCurvePlugin.set_num_thresholds(counts.Thresholds());
 
-  // Plugin metadata.
-  mlboard::SummaryMetadata_PluginData *pluginData =
-      new SummaryMetadata::PluginData();
-  pluginData->set_plugin_name("pr_curves");
-  pluginData->set_content(prCurveContent);
+  mlboard::Summary_Value *value = summary->add_value();
+  value->set_tag(tag);
 
   // Summary metadata.
-  mlboard::SummaryMetadata *metadata = new SummaryMetadata();
+  mlboard::SummaryMetadata *metadata = value->mutable_metadata();
   metadata->set_display_name(displayName == "" ? tag : displayName);
   metadata->set_summary_description(description);
-  metadata->set_allocated_plugin_data(pluginData);
+
+  // Plugin metadata.
+  mlboard::SummaryMetadata_PluginData *pluginData =
+      metadata->mutable_plugin_data();
+  pluginData->set_plugin_name("pr_curves");
+  prCurvePlugin.SerializeToString(pluginData->mutable_content());
 
   double minCount = 1e-7;
   std::vector<std::vector<double>> data;
-  while (weights.size() < labels.size())
-  {
-    weights.push_back(1.0);
-  }
-  std::vector<double> edges;
-  mlboard::util::histogramEdges({0, (double)threshold - 1},
-    threshold, edges);
-  std::vector<double> truePositives(edges.size(), 0);
-  std::vector<double> falsePositives(edges.size(), 0);
-
-  for (size_t i = 0; i < labels.size(); ++i)
-  {
-    double v = labels[i];
-    int item = predictions[i] * (threshold -1);
-    auto lb =
-        lower_bound(edges.begin(), edges.end(), item);
-    // Include the exact number in previous bucket.
-    if (*lb != item)
-        lb--;
-    truePositives[lb - edges.begin()] = truePositives[lb - edges.begin()] +
-        (v * weights[i]);
-    falsePositives[lb - edges.begin()] = falsePositives[lb - edges.begin()]
-        + ((1 - v) * weights[i]);
-  }
+  std::vector<double> truePositives(counts.TruePositives());
+  std::vector<double> falsePositives(counts.FalsePositives());
 
   // Reverse cummulative sum.
   for (int i = truePositives.size() - 2; i >= 0; i--)
@@ -442,14 +696,13 @@ void SummaryWriter<Filewriter>::PRCurve(const std::string& tag,
   data.push_back(recall);
 
   // Prepare Tensor.
-  mlboard::TensorShapeProto *tensorShape = new TensorShapeProto();
+  mlboard::TensorProto *tensor = value->mutable_tensor();
+  tensor->set_dtype(mlboard::DataType::DT_DOUBLE);
+  mlboard::TensorShapeProto *tensorShape = tensor->mutable_tensor_shape();
   mlboard::TensorShapeProto_Dim *rowDim = tensorShape->add_dim();
   rowDim->set_size(data.size());
   mlboard::TensorShapeProto_Dim *colDim = tensorShape->add_dim();
   colDim->set_size(data[0].size());
-  mlboard::TensorProto *tensor = new TensorProto();
-  tensor->set_dtype(mlboard::DataType::DT_DOUBLE);
-  tensor->set_allocated_tensor_shape(tensorShape);
   for (int i = 0; i < data.size(); i++)
   {
     for (int j = 0; j < data[0].size(); j++)
@@ -457,35 +710,26 @@ void SummaryWriter<Filewriter>::PRCurve(const std::string& tag,
       tensor->add_double_val(data[i][j]);
     }
   }
-
-  mlboard::Summary *summary = new Summary();
-  mlboard::Summary_Value *value = summary->add_value();
-  value->set_tag(tag);
-  value->set_allocated_tensor(tensor);
-  value->set_allocated_metadata(metadata);
-
-  fw.CreateEvent(0, summary);
 }
 
 template<typename Filewriter>
-template<typename vecType>
-void SummaryWriter<Filewriter>::PRCurve(const std::string& tag,
-                                        const vecType& labels,
-                                        const vecType& predictions,
-                                        Filewriter& fw,
-                                        int threshold,
-                                        vecType weights,
-                                        const std::string& displayName,
-                                        const std::string& description)
+template<typename eT>
+size_t SummaryWriter<Filewriter>::ImageChannels(
+    const arma::Mat<eT>& matrix,
+    const mlpack::data::ImageInfo& info)
 {
-  std::vector<double>convLabels(labels.memptr(), labels.memptr() +
-      labels.n_elem);
-  std::vector<double>convPredictions(predictions.memptr(),
-      predictions.memptr() + predictions.n_elem);
-  std::vector<double>convWeights(weights.memptr(), weights.memptr() +
-      weights.n_elem);
-  PRCurve(tag, convLabels, convPredictions, fw, threshold, convWeights,
-      displayName, description);
+  // Without channels, such as from MlboardLogger, every row is a channel
+  // of a pixel.
+  const size_t pixels = info.Width() * info.Height();
+  const size_t channels = (info.Channels() == 0 && pixels > 0) ?
+      matrix.n_rows / pixels : info.Channels();
+  if (matrix.n_rows != pixels * channels)
+  {
+    throw std::invalid_argument("The matrix of images has " +
+        std::to_string(matrix.n_rows) + " rows, but an image of the given "
+        "size has " + std::to_string(pixels * channels) + " values.");
+  }
+  return channels;
 }
 
 } // namespace mlboard
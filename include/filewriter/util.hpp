@@ -11,14 +11,28 @@ namespace mlboard {
 namespace util {
 
 /**
- * Function to encode images to a string given their paths.
+ * Function to encode images to a string given their paths. Every file is
+ * read with ReadFile(), and if mlboard is built with OpenMP, many files are
+ * read in parallel. A file that can't be read gives an empty string.
  * 
  * @param filePaths A vector of filepath of images to be encoded.
  * @param encodedImages Output vector to store the encoded string format image.
  */
-void EncodeImage(std::vector<std::string>& filePaths,
+void EncodeImage(const std::vector<std::string>& filePaths,
                  std::vector<std::string>& encodedImages);
 
+/**
+ * Function to read a whole file into a string. The string is sized once
+ * from the size of the file, and the file is read straight into it, without
+ * going through a stream buffer; a file that grows meanwhile is still read
+ * to the end.
+ *
+ * @param path Path of the file.
+ * @param contents Output contents of the file.
+ * @return False if the file can't be opened, true otherwise.
+ */
+bool ReadFile(const std::string& path, std::string& contents);
+
 
 /**
  * Function to compute the edges of histogram for a set of data.
@@ -31,6 +45,101 @@ void histogramEdges(const std::vector<double>& range,
                     size_t countofBins,
                     std::vector<double>& edges);
 
+/**
+ * Function to get the default edges of a histogram: exponential buckets from
+ * 1e-12 growing by 10% up to 1e20, mirrored for negative values. The edges
+ * are computed on the first call and shared by all later calls.
+ *
+ * @return Sorted vector of the default edges.
+ */
+const std::vector<double>& DefaultHistogramEdges();
+
+/**
+ * Function to find the bucket of a value in a histogram, that is the first
+ * edge that is not smaller than the value. Values beyond the last edge go to
+ * the last bucket.
+ *
+ * @param edges Sorted edges of the histogram.
+ * @param value The value to find the bucket of.
+ * @return Index of the bucket.
+ */
+size_t HistogramBucket(const std::vector<double>& edges, const double value);
+
+/**
+ * Table to look up the bucket of a value among the default histogram edges.
+ * The key of a positive double is its exponent and the leading four mantissa
+ * bits, and grows with the value; for every key the table holds the bucket,
+ * among the positive edges, of the smallest value with that key. The bucket
+ * of a value is at most one off from the guess for its key. The table is
+ * built on the first call to Get().
+ */
+class DefaultHistogramLookup
+{
+ public:
+  //! Get the table, building it on the first call.
+  static const DefaultHistogramLookup& Get();
+
+  //! Get the key of a positive value.
+  static uint64_t Key(const double value)
+  {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(double));
+    return bits >> keyShift;
+  }
+
+  //! Number of mantissa bits that are not part of the key.
+  static const int keyShift = 52 - 4;
+
+  //! Get the default histogram edges.
+  const std::vector<double>& Edges() const { return edges; }
+  //! Get the number of negative (and of positive) edges.
+  size_t Half() const { return half; }
+  //! Get the key of the smallest positive edge; smaller keys are clamped.
+  uint64_t KeyMin() const { return keyMin; }
+  //! Get the key above the largest finite edge; larger keys are clamped.
+  uint64_t KeyMax() const { return keyMax; }
+  //! Get the guessed buckets, indexed by the key minus KeyMin().
+  const uint32_t* Guess() const { return guess.data(); }
+
+ private:
+  //! Build the table.
+  DefaultHistogramLookup();
+
+  //! The default histogram edges.
+  const std::vector<double>& edges;
+
+  //! Number of negative (and of positive) edges.
+  size_t half;
+
+  //! Smallest key in the table.
+  uint64_t keyMin;
+
+  //! Largest key in the table.
+  uint64_t keyMax;
+
+  //! Bucket among the positive edges of the smallest value of every key.
+  std::vector<uint32_t> guess;
+};
+
+/**
+ * Function to find the bucket of a value among the default histogram edges
+ * in constant time. It gives the same bucket as HistogramBucket() with
+ * DefaultHistogramEdges(), but instead of a binary search it looks the bucket
+ * up in DefaultHistogramLookup, and corrects the guess with a comparison.
+ *
+ * @param value The value to find the bucket of.
+ * @return Index of the bucket in DefaultHistogramEdges().
+ */
+size_t DefaultHistogramBucket(const double value);
+
+/**
+ * Function to create a name that is different for every call, in every
+ * process on every host. It is made of the current time in nanoseconds, the
+ * hostname, the process id and a counter of the calls in this process, as in
+ * "1594962994.123456789.host.4242.0".
+ */
+std::string UniqueName();
+
 } // namespace util
 } // namespace mlboard
 
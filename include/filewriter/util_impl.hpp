@@ -11,19 +11,72 @@
 namespace mlboard {
 namespace util {
 
-inline void EncodeImage(std::vector<std::string>& filePaths,
-                 std::vector<std::string>& encodedImages)
+inline void EncodeImage(const std::vector<std::string>& filePaths,
+                        std::vector<std::string>& encodedImages)
 {
-  std::ifstream fin;
-  encodedImages.resize(filePaths.size());
-  for (size_t i = 0; i < encodedImages.size(); i++)
+  const size_t n = filePaths.size();
+  encodedImages.resize(n);
+
+  // An exception can't leave an OpenMP region, so the first one is kept and
+  // thrown once every file is read.
+  std::exception_ptr error;
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic) if (n > 1)
+#endif
+  for (ptrdiff_t i = 0; i < (ptrdiff_t) n; ++i)
+  {
+    try
+    {
+      if (!ReadFile(filePaths[i], encodedImages[i]))
+        encodedImages[i].clear();
+    }
+    catch (...)
+    {
+#ifdef _OPENMP
+      #pragma omp critical
+#endif
+      {
+        if (!error)
+          error = std::current_exception();
+      }
+    }
+  }
+
+  if (error)
+    std::rethrow_exception(error);
+}
+
+inline bool ReadFile(const std::string& path, std::string& contents)
+{
+  FILE* file = fopen(path.c_str(), "rb");
+  if (!file)
+    return false;
+
+  // Reads go straight into the string, so the FILE doesn't need a buffer.
+  setvbuf(file, nullptr, _IONBF, 0);
+  struct stat info;
+  const size_t size = (fstat(fileno(file), &info) == 0 && info.st_size > 0) ?
+      (size_t) info.st_size : 0;
+
+  contents.resize(size);
+  size_t length = size > 0 ? fread(&contents[0], 1, size, file) : 0;
+
+  // Files without a size, or that grew since, are read on in blocks.
+  if (length == size)
   {
-    std::ostringstream ss;
-    fin.open(filePaths[i], std::ios::binary);
-    ss << fin.rdbuf();
-    encodedImages[i] = ss.str();
-    fin.close();
+    char block[4096];
+    size_t count;
+    while ((count = fread(block, 1, sizeof(block), file)) > 0)
+    {
+      contents.resize(length + count);
+      std::memcpy(&contents[length], block, count);
+      length += count;
+    }
   }
+
+  contents.resize(length);
+  fclose(file);
+  return true;
 }
 
 inline void histogramEdges(const std::vector<double>& range,
@@ -40,6 +93,134 @@ inline void histogramEdges(const std::vector<double>& range,
         value = value + width;
     }
 }
+
+inline const std::vector<double>& DefaultHistogramEdges()
+{
+  struct Edges
+  {
+    Edges()
+    {
+      std::vector<double> posEdges, negEdges;
+      double v = 1e-12;
+      while (v < 1e20)
+      {
+        posEdges.push_back(v);
+        negEdges.push_back(-v);
+        v *= 1.1;
+      }
+      posEdges.push_back(std::numeric_limits<double>::max());
+      negEdges.push_back(std::numeric_limits<double>::lowest());
+
+      edges.reserve(posEdges.size() + negEdges.size());
+      edges.insert(edges.end(), negEdges.rbegin(), negEdges.rend());
+      edges.insert(edges.end(), posEdges.begin(), posEdges.end());
+    }
+
+    std::vector<double> edges;
+  };
+
+  // Built once, thread-safe since C++11.
+  static const Edges defaultEdges;
+  return defaultEdges.edges;
+}
+
+inline size_t HistogramBucket(const std::vector<double>& edges,
+                              const double value)
+{
+  const size_t bucket = std::lower_bound(edges.begin(), edges.end(), value) -
+      edges.begin();
+  return (std::min)(bucket, edges.size() - 1);
+}
+
+inline DefaultHistogramLookup::DefaultHistogramLookup() :
+    edges(DefaultHistogramEdges()),
+    half(edges.size() / 2)
+{
+  // With four mantissa bits in the key, a key covers at most a factor of
+  // 1.0625, less than the 1.1 between two edges, so the bucket guessed for a
+  // key is at most one bucket off.
+  keyMin = Key(edges[half]);
+  keyMax = Key(edges[edges.size() - 2]) + 1;
+  guess.resize(keyMax - keyMin + 1);
+  for (uint64_t key = keyMin; key <= keyMax; ++key)
+  {
+    const uint64_t bits = key << keyShift;
+    double start;
+    std::memcpy(&start, &bits, sizeof(double));
+    guess[key - keyMin] = std::lower_bound(edges.begin() + half,
+        edges.end(), start) - edges.begin() - half;
+  }
+}
+
+inline const DefaultHistogramLookup& DefaultHistogramLookup::Get()
+{
+  static const DefaultHistogramLookup lookup;
+  return lookup;
+}
+
+inline size_t DefaultHistogramBucket(const double value)
+{
+  const DefaultHistogramLookup& lookup = DefaultHistogramLookup::Get();
+  const std::vector<double>& edges = lookup.Edges();
+
+  // A binary search on NaN stops at the first bucket.
+  if (std::isnan(value))
+    return 0;
+
+  // Guess the bucket of the magnitude among the positive edges.
+  const uint64_t key = (std::min)((std::max)(
+      DefaultHistogramLookup::Key(std::fabs(value)), lookup.KeyMin()),
+      lookup.KeyMax());
+  const size_t positive = lookup.Guess()[key - lookup.KeyMin()];
+
+  // The negative edges mirror the positive ones.
+  size_t bucket = (value < 0) ? lookup.Half() - positive :
+      lookup.Half() + positive;
+
+  // Correct the guess.
+  while (bucket + 1 < edges.size() && edges[bucket] < value)
+    ++bucket;
+  while (bucket > 0 && edges[bucket - 1] >= value)
+    --bucket;
+  return bucket;
+}
+
+inline std::string UniqueName()
+{
+  static std::atomic<size_t> counter(0);
+
+  const auto now = std::chrono::system_clock::now().time_since_epoch();
+  const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(now);
+  std::string nanoseconds = std::to_string(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now - seconds)
+      .count());
+  nanoseconds.insert(0, 9 - nanoseconds.size(), '0');
+
+  std::string hostname;
+  #if defined(_WIN32)
+    const char* computerName = std::getenv("COMPUTERNAME");
+    hostname = computerName ? computerName : "localhost";
+    const long pid = _getpid();
+  #else
+    char name[256] = { 0 };
+    if (gethostname(name, sizeof(name) - 1) == 0)
+      hostname = name;
+    const long pid = getpid();
+  #endif
+
+  // Keep the name usable as a single path component.
+  for (char& c : hostname)
+  {
+    if (c == '/' || c == '\\' || c == ':')
+      c = '_';
+  }
+  if (hostname.empty())
+    hostname = "localhost";
+
+  return std::to_string(seconds.count()) + "." + nanoseconds + "." +
+      hostname + "." + std::to_string(pid) + "." + std::to_string(counter++);
+}
+
 } // namespace util
 } // namespace mlboard
 
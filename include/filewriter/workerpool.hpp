@@ -0,0 +1,101 @@
+/**
+ * @file filewriter/workerpool.hpp
+ *
+ * A pool of threads that runs heavy summaries in the background.
+ */
+#ifndef MLBOARD_WORKER_POOL_HPP
+#define MLBOARD_WORKER_POOL_HPP
+
+#include <mlboard/core.hpp>
+
+namespace mlboard {
+
+/**
+ * Class holding a fixed number of threads that run the tasks submitted to
+ * it. The tasks are started in the order they were submitted, but with more
+ * than one thread they can finish in any order. It is used by the
+ * asynchronous summaries of SummaryWriter, such as ImageAsync(), so that the
+ * training thread doesn't wait for the encoding of the summary. Tasks can be
+ * submitted from any thread.
+ */
+class WorkerPool
+{
+ public:
+  /**
+   * Create a pool and start its threads.
+   *
+   * @param threads Number of threads; the number of hardware threads if 0.
+   */
+  WorkerPool(const size_t threads = 0);
+
+  /**
+   * Run every pending task and join the threads.
+   */
+  ~WorkerPool();
+
+  // A pool owns its threads, so it can't be copied.
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  /**
+   * Function to submit a task to the pool. The returned future holds the
+   * result of the task, or the exception it threw.
+   *
+   * @param task Callable without arguments.
+   * @return Future of the result of the task.
+   */
+  template<typename TaskType>
+  std::future<typename std::result_of<TaskType()>::type> Submit(
+      TaskType&& task);
+
+  /**
+   * Function to block the calling thread until every task submitted so far
+   * has finished.
+   */
+  void Wait();
+
+  //! Get the number of threads.
+  size_t Threads() const { return threads.size(); }
+  //! Get the number of tasks that were submitted and haven't finished.
+  size_t Pending() const { return pending; }
+
+ private:
+  /**
+   * Function run by every thread, taking tasks until the pool is destroyed.
+   */
+  void Work();
+
+  //! Tasks that haven't been taken by a thread yet.
+  std::queue<std::function<void()>> tasks;
+
+  //! Threads of the pool.
+  std::vector<std::thread> threads;
+
+  //! Lock of the tasks and of the counts.
+  std::mutex mutex_;
+
+  //! Condition to wake up the threads when a task is submitted.
+  std::condition_variable taskReady;
+
+  //! Condition to wake up Wait() when every task has finished.
+  std::condition_variable tasksDone;
+
+  //! Number of tasks that were submitted and haven't finished.
+  std::atomic<size_t> pending;
+
+  //! A flag that indicates that the threads have to stop.
+  bool stopped;
+};
+
+/**
+ * Function to get the pool shared by the asynchronous summaries, with half
+ * of the hardware threads (at least one), which is started on first use.
+ */
+WorkerPool& DefaultWorkerPool();
+
+} // namespace mlboard
+
+// Include implementation.
+#include "workerpool_impl.hpp"
+
+#endif
@@ -0,0 +1,95 @@
+/**
+ * @file filewriter/workerpool_impl.hpp
+ *
+ * Implementation of the worker pool.
+ */
+#ifndef MLBOARD_WORKER_POOL_IMPL_HPP
+#define MLBOARD_WORKER_POOL_IMPL_HPP
+
+#include "workerpool.hpp"
+
+namespace mlboard {
+
+inline WorkerPool::WorkerPool(const size_t threads) :
+    pending(0),
+    stopped(false)
+{
+  size_t count = threads;
+  if (count == 0)
+    count = (std::max)(std::thread::hardware_concurrency(), 1u);
+
+  this->threads.reserve(count);
+  for (size_t i = 0; i < count; ++i)
+    this->threads.emplace_back(&WorkerPool::Work, this);
+}
+
+inline WorkerPool::~WorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped = true;
+  }
+  taskReady.notify_all();
+  for (size_t i = 0; i < threads.size(); ++i)
+    threads[i].join();
+}
+
+template<typename TaskType>
+std::future<typename std::result_of<TaskType()>::type> WorkerPool::Submit(
+    TaskType&& task)
+{
+  typedef typename std::result_of<TaskType()>::type ResultType;
+
+  // std::function has to be copyable, so the task is held by a pointer.
+  std::shared_ptr<std::packaged_task<ResultType()>> packagedTask =
+      std::make_shared<std::packaged_task<ResultType()>>(
+      std::forward<TaskType>(task));
+  std::future<ResultType> result = packagedTask->get_future();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++pending;
+    tasks.push([packagedTask]() { (*packagedTask)(); });
+  }
+  taskReady.notify_one();
+  return result;
+}
+
+inline void WorkerPool::Wait()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  tasksDone.wait(lock, [this] { return pending == 0; });
+}
+
+inline void WorkerPool::Work()
+{
+  while (true)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    taskReady.wait(lock, [this] { return stopped || !tasks.empty(); });
+    // Pending tasks are run before the threads stop.
+    if (tasks.empty())
+      return;
+
+    std::function<void()> task = std::move(tasks.front());
+    tasks.pop();
+    lock.unlock();
+
+    // A packaged task keeps its exceptions in its future.
+    task();
+
+    lock.lock();
+    if (--pending == 0)
+      tasksDone.notify_all();
+  }
+}
+
+inline WorkerPool& DefaultWorkerPool()
+{
+  static WorkerPool pool((std::max)(std::thread::hardware_concurrency() / 2,
+      1u));
+  return pool;
+}
+
+} // namespace mlboard
+
+#endif
@@ -5,6 +5,12 @@
 #include <mlboard/filewriter/filewriter.hpp>
 #include <mlboard/filewriter/summarywriter.hpp>
 #include <mlboard/filewriter/util.hpp>
+#include <mlboard/filewriter/histogram.hpp>
+#include <mlboard/filewriter/quantilesketch.hpp>
+#include <mlboard/filewriter/prcurve.hpp>
+#include <mlboard/filewriter/png.hpp>
+#include <mlboard/filewriter/resize.hpp>
+#include <mlboard/filewriter/workerpool.hpp>
 #include <mlboard/mlboard_logger.hpp>
 
 #endif
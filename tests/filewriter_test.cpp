@@ -17,16 +17,20 @@
  */
 TEST_CASE("Writing two files at a time", "[FileWriter]")
 {
-  // Both files created at the same time and hence there should be only one file.
+  // Both files created at the same time, but every filewriter has its own
+  // file.
   mlboard::FileWriter f1, f2;
   mlboard::SummaryWriter<mlboard::FileWriter>::Scalar("Sample_1", 1,
       1.1, f1);
   mlboard::SummaryWriter<mlboard::FileWriter>::Scalar("Sample_2", 1,
       1.1, f2);
 
-  REQUIRE(f1.FileName() == f2.FileName());
+  REQUIRE(f1.FileName() != f2.FileName());
   // Remove event files.
+  f1.Close();
+  f2.Close();
   remove(f1.FileName().c_str());
+  remove(f2.FileName().c_str());
 }
 
 /**
@@ -50,10 +54,472 @@ TEST_CASE("Writing two files at a time in different paths", "[FileWriter]")
       1.1, f2);
   REQUIRE(f1.FileName() != f2.FileName());
 
-  REQUIRE(f1.FileName().substr(8, f1.FileName().length()) ==
+  REQUIRE(f1.FileName().substr(0, 8) == "_temp1_/");
+  REQUIRE(f2.FileName().substr(0, 8) == "_temp2_/");
+  REQUIRE(f1.FileName().substr(8, f1.FileName().length()) !=
       f2.FileName().substr(8, f2.FileName().length()));
 
   // Remove event files.
   remove(f1.FileName().c_str());
   remove(f2.FileName().c_str());
 }
+
+/**
+ * Test that closing the filewriter doesn't wait for the flush interval.
+ */
+TEST_CASE("Closing a filewriter before the flush interval", "[FileWriter]")
+{
+  #if defined(_WIN32)
+    _mkdir("_temp3_");
+  #else
+    mkdir("_temp3_", 0777);
+  #endif
+
+  mlboard::FileWriter f1("_temp3_", 10, 60000);
+  mlboard::SummaryWriter<mlboard::FileWriter>::Scalar("Sample_1", 1,
+      1.1, f1);
+
+  const auto start = std::chrono::steady_clock::now();
+  f1.Close();
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  REQUIRE(elapsed < std::chrono::seconds(10));
+
+  // The pending event must have been written before closing.
+  std::ifstream fin(f1.FileName(), std::ios::binary | std::ios::ate);
+  REQUIRE(fin.tellg() > 0);
+  fin.close();
+
+  // Remove event files.
+  remove(f1.FileName().c_str());
+}
+
+/**
+ * Test that an idle filewriter flushes its events once the flush is due.
+ */
+TEST_CASE("Flushing an idle filewriter", "[FileWriter]")
+{
+  #if defined(_WIN32)
+    _mkdir("_temp8_");
+  #else
+    mkdir("_temp8_", 0777);
+  #endif
+
+  // Flushed when the interval passes.
+  mlboard::FileWriter f1("_temp8_", 10, 10, 0, 500);
+  // Flushed after flushmilis, as the byte count is never reached.
+  mlboard::FileWriter f2("_temp8_", 10, 10, 1 << 20, 0);
+  mlboard::SummaryWriter<mlboard::FileWriter>::Scalar("Sample_1", 1,
+      1.1, f1);
+  mlboard::SummaryWriter<mlboard::FileWriter>::Scalar("Sample_1", 1,
+      1.1, f2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+
+  // The events must be on disk before closing.
+  struct stat info;
+  REQUIRE(stat(f1.FileName().c_str(), &info) == 0);
+  REQUIRE(info.st_size > 0);
+  REQUIRE(stat(f2.FileName().c_str(), &info) == 0);
+  REQUIRE(info.st_size > 0);
+
+  f1.Close();
+  f2.Close();
+  // Remove event files.
+  remove(f1.FileName().c_str());
+  remove(f2.FileName().c_str());
+}
+
+/**
+ * Test the encoding of a batch of records.
+ */
+TEST_CASE("Encoding records into one buffer", "[FileWriter]")
+{
+  std::string buffer;
+  mlboard::FileWriter::EncodeRecord("first", buffer);
+  mlboard::FileWriter::EncodeRecord("second record", buffer);
+
+  // Every record has the length, two checksums and the data.
+  REQUIRE(buffer.size() == (5 + 16) + (13 + 16));
+
+  uint64_t len;
+  std::memcpy(&len, buffer.data(), sizeof(uint64_t));
+  REQUIRE(len == 5);
+  REQUIRE(buffer.substr(12, 5) == "first");
+
+  std::memcpy(&len, buffer.data() + 21, sizeof(uint64_t));
+  REQUIRE(len == 13);
+  REQUIRE(buffer.substr(33, 13) == "second record");
+
+  uint32_t dataCrc;
+  std::memcpy(&dataCrc, buffer.data() + 17, sizeof(uint32_t));
+  REQUIRE(dataCrc == masked_crc32c("first", 5));
+}
+
+/**
+ * Test many threads logging through a filewriter with a lock-free queue.
+ */
+TEST_CASE("Writing from many threads through a ring queue", "[FileWriter]")
+{
+  #if defined(_WIN32)
+    _mkdir("_temp4_");
+  #else
+    mkdir("_temp4_", 0777);
+  #endif
+
+  typedef mlboard::FileWriterType<mlboard::RingQueue<mlboard::Event>>
+      RingFileWriter;
+  RingFileWriter f1("_temp4_", 16, 10);
+
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 4; ++t)
+  {
+    threads.push_back(std::thread([&f1, t]()
+    {
+      for (int i = 0; i < 250; ++i)
+      {
+        mlboard::SummaryWriter<RingFileWriter>::Scalar(
+            "Sample_" + std::to_string(t), i, 1.1, f1);
+      }
+    }));
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+  f1.Close();
+
+  // Walk through the records of the file and count them.
+  std::ifstream fin(f1.FileName(), std::ios::binary);
+  size_t records = 0;
+  uint64_t len;
+  while (fin.read((char *)&len, sizeof(uint64_t)))
+  {
+    fin.seekg(len + 2 * sizeof(uint32_t), std::ios::cur);
+    ++records;
+  }
+  fin.close();
+  REQUIRE(records == 1000);
+
+  // Remove event files.
+  remove(f1.FileName().c_str());
+}
+
+/**
+ * Test the accessors of a filewriter with a lock-free queue.
+ */
+TEST_CASE("Configuring a filewriter with a ring queue", "[FileWriter]")
+{
+  #if defined(_WIN32)
+    _mkdir("_temp9_");
+  #else
+    mkdir("_temp9_", 0777);
+  #endif
+
+  typedef mlboard::FileWriterType<mlboard::RingQueue<mlboard::Event>>
+      RingFileWriter;
+  RingFileWriter f1("_temp9_", 10, 10);
+  const RingFileWriter& constF1 = f1;
+
+  // The size of a ring queue is fixed, and rounded up to a power of two.
+  REQUIRE(f1.MaxSize() == 16);
+  REQUIRE(constF1.MaxSize() == 16);
+
+  f1.FlushMilis() = 20;
+  f1.FlushBytes() = 1024;
+  f1.FlushIntervalMilis() = 100;
+  f1.MaxFileBytes() = 1 << 20;
+  f1.RotateMilis() = 60000;
+  f1.MaxFiles() = 2;
+  REQUIRE(constF1.FlushMilis() == 20);
+  REQUIRE(constF1.FlushBytes() == 1024);
+  REQUIRE(constF1.FlushIntervalMilis() == 100);
+  REQUIRE(constF1.MaxFileBytes() == (1 << 20));
+  REQUIRE(constF1.RotateMilis() == 60000);
+  REQUIRE(constF1.MaxFiles() == 2);
+  REQUIRE(f1.LogDir() == "_temp9_");
+
+  mlboard::SummaryWriter<RingFileWriter>::Scalar("Sample_1", 1, 1.1, f1);
+  f1.Close();
+  REQUIRE(f1.FileNames().size() == 1);
+  REQUIRE(std::ifstream(f1.FileName()).good());
+
+  // Remove event files.
+  remove(f1.FileName().c_str());
+}
+
+/**
+ * Test popping batches of elements from the queues.
+ */
+TEST_CASE("Popping batches from the queues", "[FileWriter]")
+{
+  mlboard::SharedQueue<int> shared(10);
+  mlboard::RingQueue<int> ring(10);
+  for (int i = 0; i < 5; ++i)
+  {
+    shared.Push(i);
+    ring.Push(i);
+  }
+
+  std::queue<int> sharedItems, ringItems;
+  REQUIRE(shared.PopBatch(2, sharedItems) == 2);
+  REQUIRE(ring.PopBatch(2, ringItems) == 2);
+  REQUIRE(shared.PopAll(sharedItems) == 3);
+  REQUIRE(ring.PopAll(ringItems) == 3);
+  REQUIRE(shared.Size() == 0);
+  REQUIRE(ring.Size() == 0);
+  REQUIRE(shared.PopAll(sharedItems) == 0);
+  REQUIRE(ring.PopAll(ringItems) == 0);
+
+  // The elements keep their order.
+  for (int i = 0; i < 5; ++i)
+  {
+    REQUIRE(sharedItems.front() == i);
+    REQUIRE(ringItems.front() == i);
+    sharedItems.pop();
+    ringItems.pop();
+  }
+}
+
+/**
+ * Test many threads pushing through a ring queue with room for one element.
+ */
+TEST_CASE("Pushing through a ring queue of capacity one", "[FileWriter]")
+{
+  mlboard::RingQueue<int> ring(1);
+  REQUIRE(ring.MaxSize() == 2);
+
+  const int count = 1000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 2; ++t)
+  {
+    threads.push_back(std::thread([&ring, t, count]()
+    {
+      for (int i = 0; i < count; ++i)
+        ring.Push(t * count + i);
+    }));
+  }
+
+  // Every element arrives, in the order of its thread.
+  std::vector<int> last(2, -1);
+  int popped = 0;
+  std::queue<int> items;
+  while (popped < 2 * count)
+  {
+    ring.Wait(std::chrono::steady_clock::now() +
+        std::chrono::milliseconds(1));
+    popped += (int) ring.PopAll(items);
+    while (!items.empty())
+    {
+      const int t = items.front() / count;
+      REQUIRE(items.front() % count == last[t] + 1);
+      last[t] = items.front() % count;
+      items.pop();
+    }
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+  REQUIRE(ring.Size() == 0);
+}
+
+/**
+ * Element type that counts how many times it was copied.
+ */
+struct CopyCounter
+{
+  static size_t copies;
+  CopyCounter() { }
+  CopyCounter(const CopyCounter&) { ++copies; }
+  CopyCounter(CopyCounter&&) { }
+  CopyCounter& operator=(const CopyCounter&) { ++copies; return *this; }
+  CopyCounter& operator=(CopyCounter&&) { return *this; }
+};
+
+size_t CopyCounter::copies = 0;
+
+/**
+ * Test that elements moved through the queues are never copied.
+ */
+TEST_CASE("Moving elements through the queues", "[FileWriter]")
+{
+  CopyCounter::copies = 0;
+  mlboard::SharedQueue<CopyCounter> shared(10);
+  mlboard::RingQueue<CopyCounter> ring(10);
+  for (int i = 0; i < 3; ++i)
+  {
+    shared.Push(CopyCounter());
+    ring.Push(CopyCounter());
+    shared.Emplace();
+    ring.Emplace();
+  }
+  shared.Pop();
+  ring.Pop();
+  std::queue<CopyCounter> sharedItems, ringItems;
+  shared.PopAll(sharedItems);
+  ring.PopAll(ringItems);
+  REQUIRE(CopyCounter::copies == 0);
+
+  // The payload of an event keeps its storage all the way through.
+  const std::string image(1 << 20, 'x');
+  mlboard::Event event;
+  event.mutable_summary()->add_value()->mutable_image()->
+      set_encoded_image_string(image);
+  const char* payload = event.summary().value(0).image().
+      encoded_image_string().data();
+
+  mlboard::SharedQueue<mlboard::Event> events(10);
+  events.Push(std::move(event));
+  std::queue<mlboard::Event> items;
+  events.PopAll(items);
+  REQUIRE(items.front().summary().value(0).image().
+      encoded_image_string().data() == payload);
+}
+
+/**
+ * Test the CRC32C checksum used for the records.
+ */
+TEST_CASE("Computing CRC32C checksums", "[FileWriter]")
+{
+  REQUIRE(crc32buf("123456789", 9) == 0xe3069283);
+
+  // Long enough to go through every block size of the hardware version,
+  // starting at an unaligned address.
+  std::string data(3 * 8192 + 3 * 256 + 21, ' ');
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = (char) (i * 31 + 7);
+
+  const uint32_t crc = crc32buf(data.data() + 1, data.size() - 1);
+  REQUIRE(crc == ~crc32c_sw(0xFFFFFFFF, data.data() + 1, data.size() - 1));
+
+  // Checksums can be chained.
+  REQUIRE(crc == crc32c(crc32c(0, data.data() + 1, 1000),
+      data.data() + 1001, data.size() - 1001));
+}
+
+/**
+ * Test a filewriter whose records are encoded by the logging threads.
+ */
+TEST_CASE("Writing records encoded by the logging thread", "[FileWriter]")
+{
+  #if defined(_WIN32)
+    _mkdir("_temp5_");
+  #else
+    mkdir("_temp5_", 0777);
+  #endif
+
+  typedef mlboard::FileWriterType<mlboard::SharedQueue<std::string>>
+      FrameFileWriter;
+  FrameFileWriter f1("_temp5_", 16, 10);
+  for (int i = 0; i < 100; ++i)
+  {
+    mlboard::SummaryWriter<FrameFileWriter>::Scalar("Sample_1", i, 1.1, f1);
+  }
+  f1.Close();
+
+  // Walk through the records of the file and check them.
+  std::ifstream fin(f1.FileName(), std::ios::binary);
+  size_t records = 0;
+  uint64_t len;
+  uint32_t lenCrc, dataCrc;
+  while (fin.read((char *)&len, sizeof(uint64_t)))
+  {
+    fin.read((char *)&lenCrc, sizeof(uint32_t));
+    REQUIRE(lenCrc == masked_crc32c((char *)&len, sizeof(uint64_t)));
+    std::string data(len, ' ');
+    fin.read(&data[0], len);
+    fin.read((char *)&dataCrc, sizeof(uint32_t));
+    REQUIRE(dataCrc == masked_crc32c(data.data(), data.size()));
+
+    mlboard::Event event;
+    REQUIRE(event.ParseFromString(data));
+    REQUIRE(event.step() == (int64_t) records);
+    ++records;
+  }
+  fin.close();
+  REQUIRE(records == 100);
+
+  // Remove event files.
+  remove(f1.FileName().c_str());
+}
+
+/**
+ * Test a filewriter that builds the summaries on arenas.
+ */
+TEST_CASE("Writing summaries built on arenas", "[FileWriter]")
+{
+  #if defined(_WIN32)
+    _mkdir("_temp6_");
+  #else
+    mkdir("_temp6_", 0777);
+  #endif
+
+  typedef mlboard::FileWriterType<mlboard::SharedQueue<mlboard::Event*>>
+      ArenaFileWriter;
+  ArenaFileWriter f1("_temp6_", 16, 10);
+  std::vector<double> values = {-1.5, 0.0, 0.25, 3.0};
+  for (int i = 0; i < 50; ++i)
+  {
+    mlboard::SummaryWriter<ArenaFileWriter>::Scalar("Sample_1", i, 1.1, f1);
+    mlboard::SummaryWriter<ArenaFileWriter>::Histogram("Sample_2", i, values,
+        f1);
+  }
+  f1.Close();
+
+  // Walk through the records of the file and parse them.
+  std::ifstream fin(f1.FileName(), std::ios::binary);
+  size_t records = 0;
+  uint64_t len;
+  uint32_t crc;
+  while (fin.read((char *)&len, sizeof(uint64_t)))
+  {
+    fin.read((char *)&crc, sizeof(uint32_t));
+    std::string data(len, ' ');
+    fin.read(&data[0], len);
+    fin.read((char *)&crc, sizeof(uint32_t));
+
+    mlboard::Event event;
+    REQUIRE(event.ParseFromString(data));
+    REQUIRE(event.step() == (int64_t) records / 2);
+    REQUIRE(event.summary().value(0).tag() ==
+        (records % 2 == 0 ? "Sample_1" : "Sample_2"));
+    ++records;
+  }
+  fin.close();
+  REQUIRE(records == 100);
+
+  // Remove event files.
+  remove(f1.FileName().c_str());
+}
+
+/**
+ * Test starting new event files once they are big enough.
+ */
+TEST_CASE("Rotating event files by size", "[FileWriter]")
+{
+  #if defined(_WIN32)
+    _mkdir("_temp7_");
+  #else
+    mkdir("_temp7_", 0777);
+  #endif
+
+  mlboard::FileWriter f1("_temp7_", 4, 0);
+  f1.MaxFileBytes() = 200;
+  f1.MaxFiles() = 3;
+  const std::string firstFile = f1.FileName();
+  for (int i = 0; i < 50; ++i)
+  {
+    mlboard::SummaryWriter<mlboard::FileWriter>::Scalar("Sample_1", i, 1.1,
+        f1);
+  }
+  f1.Close();
+
+  // Only the newest files are kept, and they sort in the order they were
+  // written.
+  std::vector<std::string> files = f1.FileNames();
+  REQUIRE(files.size() == 3);
+  REQUIRE(files.back() == f1.FileName());
+  REQUIRE(std::is_sorted(files.begin(), files.end()));
+  REQUIRE(files.front() > firstFile);
+  REQUIRE(!std::ifstream(firstFile).good());
+  for (const std::string& file : files)
+  {
+    REQUIRE(std::ifstream(file).good());
+    remove(file.c_str());
+  }
+}
@@ -96,6 +96,116 @@ TEST_CASE_METHOD(SummaryWriterTestsFixture,
       labels, predictions, *f1);
 }
 
+/**
+ * Test the PRCurve summary of predictions accumulated over many batches.
+ */
+TEST_CASE_METHOD(SummaryWriterTestsFixture,
+    "Writing a PrCurve summary using an accumulator", "[SummaryWriter]")
+{
+  std::default_random_engine generator;
+  std::uniform_real_distribution<double> distribution(0.0, 1.0);
+  mlboard::PRCurveAccumulator accumulator(50);
+  for (int epoch = 0; epoch < 3; ++epoch)
+  {
+    for (int batch = 0; batch < 10; ++batch)
+    {
+      arma::rowvec labels(1, 100), predictions(1, 100);
+      for (size_t j = 0; j < labels.n_elem; ++j)
+      {
+        labels[j] = distribution(generator) < 0.5;
+        predictions[j] = (labels[j] + distribution(generator)) / 2;
+      }
+      accumulator.Add(labels, predictions);
+    }
+
+    mlboard::SummaryWriter<mlboard::FileWriter>::PRCurve(
+        "AccumulatedPrCurve", epoch, accumulator, *f1);
+    accumulator.Reset();
+  }
+}
+
+/**
+ * Writer that keeps the last summary instead of writing it to a file. It has
+ * no NewSummary(), so the summaries are created on the heap.
+ */
+class SummaryCapture
+{
+ public:
+  void CreateEvent(size_t /* step */, mlboard::Summary* summary)
+  {
+    last.reset(summary);
+  }
+  std::unique_ptr<mlboard::Summary> last;
+};
+
+/**
+ * Test logging summaries to a writer that only has CreateEvent().
+ */
+TEST_CASE("Writing summaries without NewSummary()", "[SummaryWriter]")
+{
+  SummaryCapture capture;
+  mlboard::SummaryWriter<SummaryCapture>::Scalar("test_scalar", 1, 1.5,
+      capture);
+  REQUIRE(capture.last->value(0).tag() == "test_scalar");
+  REQUIRE(capture.last->value(0).simple_value() == 1.5);
+
+  mlboard::SummaryWriter<SummaryCapture>::Text("test_text", 1, "text",
+      capture);
+  REQUIRE(capture.last->value(0).tag() == "test_text");
+}
+
+/**
+ * Test that a PRCurve summary has one column per threshold.
+ */
+TEST_CASE("Counting the columns of a PrCurve summary", "[SummaryWriter]")
+{
+  std::vector<double> labels = {1, 1, 1, 1, 1, 1, 1, 1, 0, 1};
+  std::vector<double> predictions = {0.6458941, 0.3843817, 0.4375872,
+      0.2975346, 0.891773, 0.05671298, 0.96366274, 0.2726563,
+      0.3834415, 0.47766513};
+  for (const int threshold : {2, 3, 10, 50, 100, 127, 128, 200})
+  {
+    SummaryCapture capture;
+    mlboard::SummaryWriter<SummaryCapture>::PRCurve("test_pr_curve", labels,
+        predictions, capture, threshold);
+
+    const mlboard::Summary_Value& value = capture.last->value(0);
+    mlboard::PrCurvePluginData plugin;
+    REQUIRE(plugin.ParseFromString(
+        value.metadata().plugin_data().content()));
+    REQUIRE(plugin.num_thresholds() == (uint32_t) threshold);
+
+    const mlboard::TensorShapeProto& shape = value.tensor().tensor_shape();
+    REQUIRE(shape.dim_size() == 2);
+    REQUIRE(shape.dim(0).size() == 6);
+    REQUIRE(shape.dim(1).size() == threshold);
+    REQUIRE(value.tensor().double_val_size() == 6 * threshold);
+  }
+}
+
+/**
+ * Test the one-vs-rest PRCurve summaries of many classes.
+ */
+TEST_CASE_METHOD(SummaryWriterTestsFixture,
+    "Writing multi-class PrCurve summaries", "[SummaryWriter]")
+{
+  std::default_random_engine generator;
+  std::uniform_real_distribution<double> distribution(0.0, 1.0);
+  arma::mat scores(3, 200);
+  arma::Row<size_t> labels(1, 200);
+  for (size_t i = 0; i < scores.n_cols; ++i)
+  {
+    labels[i] = i % 3;
+    for (size_t c = 0; c < scores.n_rows; ++c)
+      scores(c, i) = (labels[i] == c) * 0.5 + distribution(generator) / 2;
+  }
+
+  mlboard::SummaryWriter<mlboard::FileWriter>::PRCurve("MultiClassPrCurve",
+      0, scores, labels, *f1);
+  mlboard::SummaryWriter<mlboard::FileWriter>::PRCurve("MultiClassPrCurve",
+      1, scores, labels, *f1, 50, arma::mat(), {"cat", "dog", "bird"});
+}
+
 /**
  * Test text summary.
  */
@@ -154,6 +264,80 @@ TEST_CASE_METHOD(SummaryWriterTestsFixture,
   }
 }
 
+/**
+ * Test Histogram summary using other arma types and subviews.
+ */
+TEST_CASE_METHOD(SummaryWriterTestsFixture,
+                "Writing histogram summary using arma fmat and subviews",
+                "[SummaryWriter]")
+{
+  arma::fmat weights(100, 50);
+  arma::Mat<int> counts(100, 50);
+  for (size_t j = 0; j < weights.n_cols; ++j)
+  {
+    for (size_t i = 0; i < weights.n_rows; ++i)
+    {
+      weights(i, j) = std::sin(i * weights.n_cols + j);
+      counts(i, j) = (i * j) % 7;
+    }
+  }
+
+  mlboard::SummaryWriter<mlboard::FileWriter>::Histogram("FloatHistogram",
+      1, weights, *f1);
+  mlboard::SummaryWriter<mlboard::FileWriter>::Histogram("IntHistogram",
+      1, counts, *f1);
+  mlboard::SummaryWriter<mlboard::FileWriter>::Histogram("SubviewHistogram",
+      1, weights.cols(10, 19), *f1);
+  mlboard::SummaryWriter<mlboard::FileWriter>::Histogram("PointerHistogram",
+      1, weights.colptr(0), weights.n_rows, *f1);
+}
+
+/**
+ * Test Histogram summary of values accumulated over many batches.
+ */
+TEST_CASE_METHOD(SummaryWriterTestsFixture,
+                "Writing histogram summary using an accumulator",
+                "[SummaryWriter]")
+{
+  std::default_random_engine generator;
+  mlboard::HistogramAccumulator accumulator;
+  for (int epoch = 0; epoch < 3; ++epoch)
+  {
+    std::normal_distribution<double> distribution(epoch * 0.1, 1.0);
+    for (int batch = 0; batch < 10; ++batch)
+    {
+      arma::rowvec activations(1, 1000);
+      for (size_t j = 0; j < activations.n_elem; ++j)
+        activations[j] = distribution(generator);
+      accumulator.Add(activations);
+    }
+
+    mlboard::SummaryWriter<mlboard::FileWriter>::Histogram(
+        "AccumulatedHistogram", epoch, accumulator, *f1);
+    accumulator.Reset();
+  }
+}
+
+/**
+ * Test Histogram summary of a quantile sketch.
+ */
+TEST_CASE_METHOD(SummaryWriterTestsFixture,
+                "Writing histogram summary using a quantile sketch",
+                "[SummaryWriter]")
+{
+  std::default_random_engine generator;
+  std::lognormal_distribution<double> distribution(0.0, 3.0);
+  for (int i = 0; i < 3; ++i)
+  {
+    mlboard::QuantileSketch sketch;
+    for (int j = 0; j < 10000; ++j)
+      sketch.Add(distribution(generator));
+
+    mlboard::SummaryWriter<mlboard::FileWriter>::Histogram("SketchHistogram",
+        i, sketch, *f1);
+  }
+}
+
 /**
  * Test embedding support.
  */
@@ -177,6 +361,79 @@ TEST_CASE_METHOD(SummaryWriterTestsFixture,
   mlboard::SummaryWriter<mlboard::FileWriter>::Embedding("vocab", temp, meta, *f1);
 }
 
+/**
+ * Test the asynchronous summaries, which have to be logged before the file
+ * writer is closed.
+ */
+TEST_CASE_METHOD(SummaryWriterTestsFixture,
+                 "Writing asynchronous summaries to file", "[SummaryWriter]")
+{
+  typedef mlboard::SummaryWriter<mlboard::FileWriter> Writer;
+
+  mlpack::data::ImageInfo info(8, 6, 3);
+  arma::mat images(8 * 6 * 3, 4);
+  for (size_t i = 0; i < images.n_elem; ++i)
+    images[i] = (i * 7) % 256;
+  std::shared_ptr<const arma::mat> sharedImages =
+      std::make_shared<arma::mat>(images);
+
+  arma::mat scores(3, 50);
+  arma::Row<size_t> classes(50);
+  for (size_t i = 0; i < scores.n_cols; ++i)
+  {
+    classes[i] = i % 3;
+    for (size_t c = 0; c < scores.n_rows; ++c)
+      scores(c, i) = (c == classes[i]) ? 0.8 : 0.1 * c;
+  }
+
+  std::vector<std::future<void>> futures;
+  futures.push_back(Writer::ImageAsync("Async Image", 1, images, info, *f1));
+  futures.push_back(Writer::ImageAsync("Async Shared Image", 1, sharedImages,
+      info, *f1));
+  futures.push_back(Writer::EmbeddingAsync("async_vocab", arma::mat(4, 3,
+      arma::fill::randu), {"a", "b", "c"}, *f1, "_templogs/async_tensor.tsv",
+      "_templogs/async_meta.tsv", "async_tensor.tsv", "async_meta.tsv"));
+  futures.push_back(Writer::PRCurveAsync("async_pr_curve", {1, 0, 1, 1},
+      {0.9, 0.4, 0.3, 0.8}, *f1));
+  futures.push_back(Writer::PRCurveAsync("async_class_pr_curve", 1, scores,
+      classes, *f1));
+
+  // The caller's copy can change once it is submitted.
+  images.zeros();
+  for (size_t i = 0; i < futures.size(); ++i)
+    futures[i].get();
+
+  // Errors are thrown by the future.
+  std::future<void> failed = Writer::ImageAsync("Async Image", 1,
+      arma::mat(5, 1), info, *f1);
+  REQUIRE_THROWS_AS(failed.get(), std::invalid_argument);
+
+  #ifndef KEEP_TEST_LOGS
+    remove("_templogs/async_tensor.tsv");
+    remove("_templogs/async_meta.tsv");
+  #endif
+}
+
+/**
+ * Test the thumbnails of the images of a matrix.
+ */
+TEST_CASE_METHOD(SummaryWriterTestsFixture,
+                 "Writing image thumbnails to file", "[SummaryWriter]")
+{
+  arma::mat images(100 * 60 * 3, 3);
+  for (size_t i = 0; i < images.n_elem; ++i)
+    images[i] = (i * 7) % 300;
+
+  mlboard::SummaryWriter<mlboard::FileWriter>::Image("Thumbnails", 1, images,
+      mlpack::data::ImageInfo(100, 60, 3), 32, 32, *f1);
+  mlboard::SummaryWriter<mlboard::FileWriter>::Image("Bilinear Thumbnails", 1,
+      images, mlpack::data::ImageInfo(100, 60, 0), 32, 32, *f1,
+      mlboard::util::ResizeFilter::Bilinear, "Bilinear Thumbnails");
+  REQUIRE_THROWS_AS(mlboard::SummaryWriter<mlboard::FileWriter>::Image(
+      "Thumbnails", 1, images, mlpack::data::ImageInfo(100, 60, 2), 32, 32,
+      *f1), std::invalid_argument);
+}
+
 /**
  * Test multiple Image summary.
  */
@@ -195,6 +452,15 @@ TEST_CASE_METHOD(SummaryWriterTestsFixture, "Writing multiple Images summary to
   mlboard::SummaryWriter<mlboard::FileWriter>::Image(
       "Multiple Image", 1, matrix, info, *f1, "Sample Multiple Image",
       "This is a Sample multiple image logged using mlboard.");
+
+  // Without channels, as from MlboardLogger, they come from the rows.
+  mlpack::data::ImageInfo noChannels(info.Width(), info.Height(), 0);
+  mlboard::SummaryWriter<mlboard::FileWriter>::Image(
+      "Multiple Image Without Channels", 1, matrix, noChannels, *f1);
+  REQUIRE_THROWS_AS(mlboard::SummaryWriter<mlboard::FileWriter>::Image(
+      "Multiple Image Without Channels", 1,
+      arma::Mat<unsigned char>(matrix.n_rows + 1, 1), noChannels, *f1),
+      std::invalid_argument);
   f1->Close();
 
   #ifndef KEEP_TEST_LOGS
@@ -5,6 +5,8 @@
 #include <mlboard/core.hpp>
 #include "catch.hpp"
 
+#include <numeric>
+
 /**
  * Test EncodeImage utitlity function.
  */
@@ -17,4 +19,759 @@ TEST_CASE("Test EncodeImage utitlity function", "[UtilFunction]")
   REQUIRE(encodeImage.size() == 2);
   REQUIRE(encodeImage[0].length() > 0);
   REQUIRE(encodeImage[1].length() > 0);
+
+  // Many files are read in parallel, in order, and byte for byte; files that
+  // can't be read are empty.
+  for (size_t i = 0; i < 20; ++i)
+    filePaths.push_back(filePaths[i % 2]);
+  filePaths.push_back("data/missing_image.jpg");
+  mlboard::util::EncodeImage(filePaths, encodeImage);
+  REQUIRE(encodeImage.size() == filePaths.size());
+  for (size_t i = 0; i + 1 < filePaths.size(); ++i)
+  {
+    std::ifstream fin(filePaths[i], std::ios::binary);
+    std::ostringstream ss;
+    ss << fin.rdbuf();
+    REQUIRE(encodeImage[i] == ss.str());
+  }
+  REQUIRE(encodeImage.back().empty());
+}
+
+/**
+ * Test ReadFile utility function.
+ */
+TEST_CASE("Test ReadFile utility function", "[UtilFunction]")
+{
+  std::string contents = "old contents";
+  REQUIRE(!mlboard::util::ReadFile("data/missing_image.jpg", contents));
+
+  std::ofstream("_read_file_test.bin", std::ios::binary).close();
+  REQUIRE(mlboard::util::ReadFile("_read_file_test.bin", contents));
+  REQUIRE(contents.empty());
+
+  std::string bytes(100000, '\0');
+  for (size_t i = 0; i < bytes.size(); ++i)
+    bytes[i] = (char) (i * 31 % 256);
+  std::ofstream("_read_file_test.bin", std::ios::binary) << bytes;
+  REQUIRE(mlboard::util::ReadFile("_read_file_test.bin", contents));
+  REQUIRE(contents == bytes);
+  remove("_read_file_test.bin");
+}
+
+/**
+ * Test UniqueName utility function.
+ */
+TEST_CASE("Test UniqueName utility function", "[UtilFunction]")
+{
+  std::vector<std::string> names;
+  for (size_t i = 0; i < 100; ++i)
+    names.push_back(mlboard::util::UniqueName());
+
+  std::sort(names.begin(), names.end());
+  REQUIRE(std::unique(names.begin(), names.end()) == names.end());
+  REQUIRE(names[0].find('/') == std::string::npos);
+}
+
+/**
+ * Test DefaultHistogramEdges utility function.
+ */
+TEST_CASE("Test DefaultHistogramEdges utility function", "[UtilFunction]")
+{
+  const std::vector<double>& edges = mlboard::util::DefaultHistogramEdges();
+
+  // The edges are only built once.
+  REQUIRE(&edges == &mlboard::util::DefaultHistogramEdges());
+  REQUIRE(edges.size() % 2 == 0);
+  REQUIRE(std::is_sorted(edges.begin(), edges.end()));
+  REQUIRE(edges.front() == std::numeric_limits<double>::lowest());
+  REQUIRE(edges.back() == std::numeric_limits<double>::max());
+  REQUIRE(edges[edges.size() / 2] == 1e-12);
+  REQUIRE(edges[edges.size() / 2 - 1] == -1e-12);
+}
+
+/**
+ * Test that DefaultHistogramBucket() finds the same buckets as a binary search.
+ */
+TEST_CASE("Test DefaultHistogramBucket utility function", "[UtilFunction]")
+{
+  const std::vector<double>& edges = mlboard::util::DefaultHistogramEdges();
+
+  // Every edge and its neighbours, and values around and beyond the edges.
+  std::vector<double> values = {0.0, -0.0, 1e-300, -1e-300, 1.0, -1.0, 1e300,
+      -1e300, std::numeric_limits<double>::max(),
+      std::numeric_limits<double>::infinity(),
+      -std::numeric_limits<double>::infinity()};
+  for (double edge : edges)
+  {
+    values.push_back(edge);
+    values.push_back(std::nextafter(edge, 0.0));
+    values.push_back(std::nextafter(edge, edge * 2));
+    values.push_back(edge * 1.05);
+  }
+  for (double v = 1e-14; v < 1e22; v *= 1.01)
+  {
+    values.push_back(v);
+    values.push_back(-v);
+  }
+
+  for (double v : values)
+  {
+    REQUIRE(mlboard::util::DefaultHistogramBucket(v) ==
+        mlboard::util::HistogramBucket(edges, v));
+  }
+
+  // Values beyond the last edge go to the last bucket.
+  REQUIRE(mlboard::util::DefaultHistogramBucket(
+      std::numeric_limits<double>::infinity()) == edges.size() - 1);
+}
+
+/**
+ * Test that the vector histogram kernels agree with the scalar one.
+ */
+TEST_CASE("Test HistogramUpdate kernels", "[UtilFunction]")
+{
+  const std::vector<double>& edges = mlboard::util::DefaultHistogramEdges();
+  const std::vector<double> bins = {-1, 0, 0.5, 1, 2, 1e300};
+
+  // Values around the edges, special values and a ragged tail for the
+  // vectors.
+  std::vector<double> values = {0.0, -0.0, 1e-300, -1e-300, 1e300, -1e300,
+      std::numeric_limits<double>::max(),
+      std::numeric_limits<double>::lowest(),
+      std::numeric_limits<double>::infinity(),
+      -std::numeric_limits<double>::infinity()};
+  for (size_t i = 0; i < edges.size(); i += 3)
+  {
+    values.push_back(edges[i]);
+    values.push_back(std::nextafter(edges[i], 0.0));
+    values.push_back(edges[i] * 1.05);
+  }
+  for (size_t i = 0; i < 10001; ++i)
+    values.push_back(std::sin(i) * std::exp(i % 50));
+  values.push_back(std::nan(""));
+
+  typedef void (*Kernel)(const double*, const size_t,
+      const std::vector<double>&, mlboard::util::HistogramStats&);
+  std::vector<Kernel> kernels = {mlboard::util::HistogramKernel};
+  #ifdef MLBOARD_HISTOGRAM_AVX
+  if (mlboard::util::HistogramAVX2Supported())
+    kernels.push_back(mlboard::util::HistogramUpdateAVX2);
+  if (mlboard::util::HistogramAVX512Supported())
+    kernels.push_back(mlboard::util::HistogramUpdateAVX512);
+  #endif
+
+  for (const std::vector<double>* b : {&edges, &bins})
+  {
+    mlboard::util::HistogramStats expected(b->size());
+    mlboard::util::HistogramUpdateScalar(values.data(), values.size(), *b,
+        expected);
+    REQUIRE(expected.Min() == -std::numeric_limits<double>::infinity());
+    REQUIRE(expected.Max() == std::numeric_limits<double>::infinity());
+
+    for (Kernel kernel : kernels)
+    {
+      // Leave out the NaN for the sums, and start from earlier statistics.
+      mlboard::util::HistogramStats stats(b->size());
+      kernel(values.data(), 5, *b, stats);
+      kernel(values.data() + 5, values.size() - 5, *b, stats);
+      REQUIRE(stats.Num() == expected.Num());
+      REQUIRE(stats.Min() == expected.Min());
+      REQUIRE(stats.Max() == expected.Max());
+      REQUIRE(stats.Counts() == expected.Counts());
+
+      const size_t n = 10001;
+      mlboard::util::HistogramStats finite(b->size());
+      mlboard::util::HistogramStats finiteExpected(b->size());
+      kernel(values.data() + values.size() - n - 1, n, *b, finite);
+      mlboard::util::HistogramUpdateScalar(
+          values.data() + values.size() - n - 1, n, *b, finiteExpected);
+      REQUIRE(finite.Sum() == Approx(finiteExpected.Sum()));
+      REQUIRE(finite.SumSquares() == Approx(finiteExpected.SumSquares()));
+    }
+  }
+}
+
+/**
+ * Test that HistogramUpdate() gives the same statistics in parallel.
+ */
+TEST_CASE("Test parallel HistogramUpdate", "[UtilFunction]")
+{
+  const std::vector<double>& edges = mlboard::util::DefaultHistogramEdges();
+  std::vector<double> values(100003);
+  for (size_t i = 0; i < values.size(); ++i)
+    values[i] = std::sin(i) * std::exp(i % 50);
+
+  mlboard::util::HistogramStats expected(edges.size());
+  mlboard::util::HistogramUpdateScalar(values.data(), values.size(), edges,
+      expected);
+
+  const size_t parallelSize = mlboard::util::HistogramParallelSize();
+  mlboard::util::HistogramParallelSize() = 1000;
+  mlboard::util::HistogramStats stats(edges.size());
+  mlboard::util::HistogramUpdate(values.data(), values.size(), edges, stats);
+  mlboard::util::HistogramParallelSize() = parallelSize;
+
+  REQUIRE(stats.Num() == expected.Num());
+  REQUIRE(stats.Min() == expected.Min());
+  REQUIRE(stats.Max() == expected.Max());
+  REQUIRE(stats.Sum() == Approx(expected.Sum()));
+  REQUIRE(stats.SumSquares() == Approx(expected.SumSquares()));
+  REQUIRE(stats.Counts() == expected.Counts());
+}
+
+/**
+ * Test that HistogramUpdate() takes values of other types.
+ */
+TEST_CASE("Test HistogramUpdate with float and integer values",
+          "[UtilFunction]")
+{
+  const std::vector<double>& edges = mlboard::util::DefaultHistogramEdges();
+  std::vector<float> floats(5000);
+  std::vector<int> ints(5000);
+  for (size_t i = 0; i < floats.size(); ++i)
+  {
+    floats[i] = std::sin(i) * std::exp(i % 20);
+    ints[i] = (int) i - 2500;
+  }
+
+  for (int k = 0; k < 2; ++k)
+  {
+    mlboard::util::HistogramStats stats(edges.size());
+    mlboard::util::HistogramStats expected(edges.size());
+    if (k == 0)
+    {
+      std::vector<double> values(floats.begin(), floats.end());
+      mlboard::util::HistogramUpdate(floats.data(), floats.size(), edges,
+          stats);
+      mlboard::util::HistogramUpdate(values.data(), values.size(), edges,
+          expected);
+    }
+    else
+    {
+      std::vector<double> values(ints.begin(), ints.end());
+      mlboard::util::HistogramUpdate(ints.data(), ints.size(), edges, stats);
+      mlboard::util::HistogramUpdate(values.data(), values.size(), edges,
+          expected);
+    }
+
+    REQUIRE(stats.Num() == expected.Num());
+    REQUIRE(stats.Min() == expected.Min());
+    REQUIRE(stats.Max() == expected.Max());
+    REQUIRE(stats.Sum() == Approx(expected.Sum()));
+    REQUIRE(stats.SumSquares() == Approx(expected.SumSquares()));
+    REQUIRE(stats.Counts() == expected.Counts());
+  }
+}
+
+/**
+ * Test that HistogramAccumulator gives the same statistics as one update.
+ */
+TEST_CASE("Test HistogramAccumulator", "[UtilFunction]")
+{
+  std::vector<double> values(10000);
+  for (size_t i = 0; i < values.size(); ++i)
+    values[i] = std::sin(i) * std::exp(i % 30);
+
+  for (int k = 0; k < 2; ++k)
+  {
+    const std::vector<double> bins = {-10, -1, 0, 1, 10, 1e300};
+    mlboard::HistogramAccumulator accumulator = (k == 0) ?
+        mlboard::HistogramAccumulator() : mlboard::HistogramAccumulator(bins);
+    mlboard::HistogramAccumulator other(accumulator.Bins());
+
+    // Feed the values in batches, some of them to another accumulator.
+    std::vector<float> floats(values.begin(), values.end());
+    for (size_t i = 0; i < values.size(); i += 1000)
+    {
+      if (i % 3000 == 0)
+        other.Add(floats.data() + i, 1000);
+      else
+        accumulator.Add(std::vector<double>(floats.begin() + i,
+            floats.begin() + i + 1000));
+    }
+    accumulator.Merge(other);
+
+    mlboard::util::HistogramStats expected(accumulator.Bins().size());
+    mlboard::util::HistogramUpdate(floats.data(), floats.size(),
+        accumulator.Bins(), expected);
+
+    const mlboard::util::HistogramStats& stats = accumulator.Stats();
+    REQUIRE(stats.Num() == values.size());
+    REQUIRE(stats.Min() == expected.Min());
+    REQUIRE(stats.Max() == expected.Max());
+    REQUIRE(stats.Sum() == Approx(expected.Sum()));
+    REQUIRE(stats.SumSquares() == Approx(expected.SumSquares()));
+    REQUIRE(stats.Counts() == expected.Counts());
+
+    accumulator.Reset();
+    REQUIRE(accumulator.Stats().Num() == 0);
+    REQUIRE(accumulator.Stats().Counts().size() ==
+        accumulator.Bins().size());
+  }
+}
+
+/**
+ * Test that QuantileSketch finds quantiles within its relative accuracy.
+ */
+TEST_CASE("Test QuantileSketch", "[UtilFunction]")
+{
+  // Values over many orders of magnitude, of both signs, split between two
+  // sketches.
+  std::vector<double> values;
+  for (size_t i = 0; i < 20000; ++i)
+    values.push_back(std::exp(std::sin(i) * 20) * (i % 3 == 0 ? -1 : 1));
+  values.push_back(0.0);
+
+  mlboard::QuantileSketch sketch(0.01), other(0.01);
+  for (size_t i = 0; i < values.size(); ++i)
+  {
+    if (i % 2 == 0)
+      sketch.Add(values[i]);
+    else
+      other.Add(&values[i], 1);
+  }
+  sketch.Merge(other);
+
+  std::vector<double> sorted(values);
+  std::sort(sorted.begin(), sorted.end());
+  REQUIRE(sketch.Num() == values.size());
+  REQUIRE(sketch.Min() == sorted.front());
+  REQUIRE(sketch.Max() == sorted.back());
+  for (double q : {0.0, 0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99, 1.0})
+  {
+    const double expected = sorted[(size_t) (q * (sorted.size() - 1) + 0.5)];
+    REQUIRE(std::fabs(sketch.Quantile(q) - expected) <=
+        0.01 * std::fabs(expected) + 1e-300);
+  }
+
+  // The buckets are increasing and hold every value.
+  std::vector<double> limits, counts;
+  sketch.Buckets(limits, counts);
+  REQUIRE(std::is_sorted(limits.begin(), limits.end()));
+  REQUIRE(std::accumulate(counts.begin(), counts.end(), 0.0) ==
+      values.size());
+
+  // The memory is bounded; the smallest magnitudes are collapsed.
+  mlboard::QuantileSketch small(0.01, 64);
+  small.Add(values);
+  small.Buckets(limits, counts);
+  REQUIRE(limits.size() <= 2 * 64 + 1);
+  REQUIRE(std::accumulate(counts.begin(), counts.end(), 0.0) ==
+      values.size());
+  REQUIRE(small.Quantile(1.0) == Approx(sorted.back()).epsilon(0.01));
+
+  REQUIRE_THROWS_AS(sketch.Merge(mlboard::QuantileSketch(0.02)),
+      std::invalid_argument);
+  sketch.Reset();
+  REQUIRE(sketch.Num() == 0);
+}
+
+/**
+ * Test that PRCurveUpdate() finds the same buckets as a binary search over the
+ * thresholds, also in parallel and for predictions outside [0, 1].
+ */
+TEST_CASE("Test PRCurveUpdate", "[UtilFunction]")
+{
+  const size_t thresholds = 127;
+  std::vector<double> labels(100003), predictions(100003), weights(100003);
+  for (size_t i = 0; i < labels.size(); ++i)
+  {
+    labels[i] = i % 3 == 0;
+    predictions[i] = std::fabs(std::sin(i * 0.7));
+    weights[i] = 1 + i % 5;
+  }
+
+  std::vector<double> edges;
+  mlboard::util::histogramEdges({0, (double) thresholds - 1}, thresholds,
+      edges);
+  mlboard::util::PRCurveCounts expected(thresholds);
+  for (size_t i = 0; i < labels.size(); ++i)
+  {
+    const int item = predictions[i] * (thresholds - 1);
+    std::vector<double>::iterator lb = std::lower_bound(edges.begin(),
+        edges.end(), item);
+    if (*lb != item)
+      lb--;
+    expected.TruePositives()[lb - edges.begin()] += labels[i] * weights[i];
+    expected.FalsePositives()[lb - edges.begin()] +=
+        (1 - labels[i]) * weights[i];
+  }
+
+  mlboard::util::PRCurveCounts counts(thresholds);
+  mlboard::util::PRCurveUpdate(labels.data(), predictions.data(),
+      weights.data(), labels.size(), counts);
+  REQUIRE(counts.TruePositives() == expected.TruePositives());
+  REQUIRE(counts.FalsePositives() == expected.FalsePositives());
+
+  const size_t parallelSize = mlboard::util::PRCurveParallelSize();
+  mlboard::util::PRCurveParallelSize() = 1000;
+  mlboard::util::PRCurveCounts parallel(thresholds);
+  mlboard::util::PRCurveUpdate(labels.data(), predictions.data(),
+      weights.data(), labels.size(), parallel);
+  mlboard::util::PRCurveParallelSize() = parallelSize;
+  for (size_t i = 0; i < thresholds; ++i)
+  {
+    REQUIRE(parallel.TruePositives()[i] ==
+        Approx(expected.TruePositives()[i]));
+    REQUIRE(parallel.FalsePositives()[i] ==
+        Approx(expected.FalsePositives()[i]));
+  }
+
+  // Without weights every label weighs 1; predictions below 0 and NaN go to
+  // the first bucket, and those above 1 to the last.
+  const std::vector<float> outLabels = {1, 0, 1, 0};
+  const std::vector<float> outPredictions = {-0.5, std::nanf(""), 1.5, 1};
+  mlboard::util::PRCurveCounts out(10);
+  mlboard::util::PRCurveUpdate(outLabels.data(), outPredictions.data(),
+      (const float*) nullptr, outLabels.size(), out);
+  REQUIRE(out.TruePositives()[0] == 1);
+  REQUIRE(out.FalsePositives()[0] == 1);
+  REQUIRE(out.TruePositives()[9] == 1);
+  REQUIRE(out.FalsePositives()[9] == 1);
+  REQUIRE(std::accumulate(out.TruePositives().begin(),
+      out.TruePositives().end(), 0.0) == 2);
+}
+
+/**
+ * Test that PRCurveAccumulator counts batches like a single PRCurveUpdate().
+ */
+TEST_CASE("Test PRCurveAccumulator", "[UtilFunction]")
+{
+  std::vector<double> labels(1000), predictions(1000), weights(1000);
+  for (size_t i = 0; i < labels.size(); ++i)
+  {
+    labels[i] = i % 4 == 0;
+    predictions[i] = std::fabs(std::cos(i * 1.3));
+    weights[i] = 0.5 + i % 3;
+  }
+
+  mlboard::util::PRCurveCounts expected(20);
+  mlboard::util::PRCurveUpdate(labels.data(), predictions.data(),
+      weights.data(), labels.size(), expected);
+
+  mlboard::PRCurveAccumulator accumulator(20), other(20);
+  accumulator.Add(labels.data(), predictions.data(), 400, weights.data());
+  other.Add(std::vector<double>(labels.begin() + 400, labels.end()),
+      std::vector<double>(predictions.begin() + 400, predictions.end()),
+      std::vector<double>(weights.begin() + 400, weights.end()));
+  accumulator.Merge(other);
+  for (size_t i = 0; i < 20; ++i)
+  {
+    REQUIRE(accumulator.Counts().TruePositives()[i] ==
+        Approx(expected.TruePositives()[i]));
+    REQUIRE(accumulator.Counts().FalsePositives()[i] ==
+        Approx(expected.FalsePositives()[i]));
+  }
+
+  // Labels without a weight weigh 1.
+  accumulator.Reset();
+  REQUIRE(accumulator.Thresholds() == 20);
+  accumulator.Add(std::vector<double>{1, 1, 0}, std::vector<double>{1, 1, 1},
+      std::vector<double>{3});
+  REQUIRE(accumulator.Counts().TruePositives()[19] == 4);
+  REQUIRE(accumulator.Counts().FalsePositives()[19] == 1);
+
+  // Without weights, every label weighs 1, for vectors and Armadillo vectors.
+  mlboard::util::PRCurveCounts unweighted(20);
+  mlboard::util::PRCurveUpdate(labels.data(), predictions.data(),
+      (const double*) nullptr, labels.size(), unweighted);
+  mlboard::PRCurveAccumulator vectors(20), armaVectors(20);
+  vectors.Add(labels, predictions);
+  vectors.Add(labels, predictions, std::vector<double>());
+  const arma::rowvec armaLabels(labels), armaPredictions(predictions);
+  armaVectors.Add(armaLabels, armaPredictions);
+  armaVectors.Add(armaLabels, armaPredictions, arma::rowvec());
+  for (size_t i = 0; i < 20; ++i)
+  {
+    REQUIRE(vectors.Counts().TruePositives()[i] ==
+        2 * unweighted.TruePositives()[i]);
+    REQUIRE(vectors.Counts().FalsePositives()[i] ==
+        2 * unweighted.FalsePositives()[i]);
+    REQUIRE(armaVectors.Counts().TruePositives()[i] ==
+        2 * unweighted.TruePositives()[i]);
+    REQUIRE(armaVectors.Counts().FalsePositives()[i] ==
+        2 * unweighted.FalsePositives()[i]);
+  }
+}
+
+/**
+ * Test that MultiClassPRCurveUpdate() counts every class like PRCurveUpdate()
+ * with one-vs-rest labels, also in parallel.
+ */
+TEST_CASE("Test MultiClassPRCurveUpdate", "[UtilFunction]")
+{
+  const size_t classes = 7, n = 5003;
+  std::vector<double> scores(classes * n), weights(n);
+  std::vector<size_t> labels(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    labels[i] = (i * 5) % classes;
+    weights[i] = 1 + i % 4;
+    for (size_t c = 0; c < classes; ++c)
+      scores[i * classes + c] = std::fabs(std::sin(i * 0.37 + c));
+  }
+
+  std::vector<mlboard::util::PRCurveCounts> counts(classes,
+      mlboard::util::PRCurveCounts(30));
+  mlboard::util::MultiClassPRCurveUpdate(scores.data(), labels.data(),
+      weights.data(), n, counts);
+
+  const size_t parallelSize = mlboard::util::PRCurveParallelSize();
+  mlboard::util::PRCurveParallelSize() = 1000;
+  std::vector<mlboard::util::PRCurveCounts> parallel(classes,
+      mlboard::util::PRCurveCounts(30));
+  mlboard::util::MultiClassPRCurveUpdate(scores.data(), labels.data(),
+      weights.data(), n, parallel);
+  mlboard::util::PRCurveParallelSize() = parallelSize;
+
+  for (size_t c = 0; c < classes; ++c)
+  {
+    std::vector<double> classLabels(n), classScores(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+      classLabels[i] = labels[i] == c;
+      classScores[i] = scores[i * classes + c];
+    }
+
+    mlboard::util::PRCurveCounts expected(30);
+    mlboard::util::PRCurveKernel(classLabels.data(), classScores.data(),
+        weights.data(), n, expected);
+    REQUIRE(counts[c].TruePositives() == expected.TruePositives());
+    REQUIRE(counts[c].FalsePositives() == expected.FalsePositives());
+    REQUIRE(parallel[c].TruePositives() == expected.TruePositives());
+    REQUIRE(parallel[c].FalsePositives() == expected.FalsePositives());
+  }
+}
+
+/**
+ * Test the structure of the PNG images made by EncodePNG().
+ */
+TEST_CASE("Test EncodePNG", "[UtilFunction]")
+{
+  const unsigned char check[] = "123456789";
+  REQUIRE(mlboard::util::PNGCrc32(0, check, 9) == 0xCBF43926u);
+
+  std::vector<unsigned char> pixels(40 * 30 * 3);
+  for (size_t i = 0; i < pixels.size(); ++i)
+    pixels[i] = (i / 3) % 40 * 6;
+
+  std::string png;
+  mlboard::util::EncodePNG(pixels.data(), 40, 30, 3, png);
+  REQUIRE(png.substr(0, 8) == std::string("\x89PNG\r\n\x1a\n", 8));
+
+  // Every chunk has the CRC of its type and data; the header holds the size
+  // and the RGB color type.
+  std::vector<std::string> types;
+  size_t pos = 8;
+  while (pos + 12 <= png.size())
+  {
+    const unsigned char* chunk = (const unsigned char*) png.data() + pos;
+    const size_t length = size_t(chunk[0]) << 24 | size_t(chunk[1]) << 16 |
+        size_t(chunk[2]) << 8 | chunk[3];
+    REQUIRE(pos + 12 + length <= png.size());
+    const unsigned char* crc = chunk + 8 + length;
+    REQUIRE(mlboard::util::PNGCrc32(0, chunk + 4, length + 4) ==
+        (uint32_t(crc[0]) << 24 | uint32_t(crc[1]) << 16 |
+        uint32_t(crc[2]) << 8 | crc[3]));
+    types.push_back(png.substr(pos + 4, 4));
+    if (types.back() == "IHDR")
+    {
+      REQUIRE(chunk[11] == 40);
+      REQUIRE(chunk[15] == 30);
+      REQUIRE(chunk[16] == 8);
+      REQUIRE(chunk[17] == 2);
+    }
+    pos += 12 + length;
+  }
+  REQUIRE(pos == png.size());
+  REQUIRE(types == std::vector<std::string>({"IHDR", "IDAT", "IEND"}));
+
+  // The rows repeat, so they compress well.
+  REQUIRE(png.size() < pixels.size() / 4);
+
+  // Other pixel types are clamped to 8 bits.
+  std::vector<double> values(pixels.begin(), pixels.end());
+  values[0] = -3;
+  values[1] = 1000;
+  pixels[0] = 0;
+  pixels[1] = 255;
+  std::string fromValues;
+  mlboard::util::EncodePNG(values.data(), 40, 30, 3, fromValues);
+  mlboard::util::EncodePNG(pixels.data(), 40, 30, 3, png);
+  REQUIRE(fromValues == png);
+
+  REQUIRE_THROWS_AS(mlboard::util::EncodePNG(pixels.data(), 40, 30, 5, png),
+      std::invalid_argument);
+  REQUIRE_THROWS_AS(mlboard::util::EncodePNG(pixels.data(), 0, 30, 3, png),
+      std::invalid_argument);
+}
+
+/**
+ * Test that the columns of a matrix are encoded in order, also in parallel.
+ */
+TEST_CASE("Test EncodePNG of a matrix", "[UtilFunction]")
+{
+  arma::mat images(8 * 6 * 3, 37);
+  for (size_t j = 0; j < images.n_cols; ++j)
+  {
+    for (size_t i = 0; i < images.n_rows; ++i)
+      images(i, j) = (i * 7 + j * 13) % 256;
+  }
+
+  std::vector<std::string> encodedImages;
+  mlboard::util::EncodePNG(images, 8, 6, 3, encodedImages);
+  REQUIRE(encodedImages.size() == images.n_cols);
+  for (size_t j = 0; j < images.n_cols; ++j)
+  {
+    std::string png;
+    mlboard::util::EncodePNG(images.colptr(j), 8, 6, 3, png);
+    REQUIRE(encodedImages[j] == png);
+  }
+
+  REQUIRE_THROWS_AS(mlboard::util::EncodePNG(images, 8, 6, 6, encodedImages),
+      std::invalid_argument);
+}
+
+/**
+ * Test that the worker pool runs every task and keeps its results and
+ * exceptions.
+ */
+TEST_CASE("Test WorkerPool", "[UtilFunction]")
+{
+  mlboard::WorkerPool pool(3);
+  REQUIRE(pool.Threads() == 3);
+
+  std::atomic<int> sum(0);
+  std::vector<std::future<int>> results;
+  for (int i = 0; i < 100; ++i)
+    results.push_back(pool.Submit([i, &sum]() { sum += i; return i * i; }));
+
+  for (int i = 0; i < 100; ++i)
+    REQUIRE(results[i].get() == i * i);
+  REQUIRE(sum == 4950);
+
+  std::future<void> failed = pool.Submit([]()
+      { throw std::invalid_argument("failed task"); });
+  REQUIRE_THROWS_AS(failed.get(), std::invalid_argument);
+
+  for (int i = 0; i < 10; ++i)
+    pool.Submit([&sum]() { ++sum; });
+  pool.Wait();
+  REQUIRE(pool.Pending() == 0);
+  REQUIRE(sum == 4960);
+}
+
+/**
+ * Test that images are resized with the weights of their filter, and
+ * quantized to 8 bits.
+ */
+TEST_CASE("Test ResizeImages", "[UtilFunction]")
+{
+  using mlboard::util::ResizeFilter;
+  arma::Mat<unsigned char> resized;
+
+  // Without a new size, the values are only clamped and rounded.
+  arma::mat values(5, 1);
+  values[0] = -3;
+  values[1] = 1000;
+  values[2] = 12.4;
+  values[3] = 12.6;
+  values[4] = std::numeric_limits<double>::quiet_NaN();
+  mlboard::util::ResizeImages(values, 5, 1, 1, 5, 1, ResizeFilter::Box,
+      resized);
+  REQUIRE(resized.n_rows == 5);
+  REQUIRE(resized[0] == 0);
+  REQUIRE(resized[1] == 255);
+  REQUIRE(resized[2] == 12);
+  REQUIRE(resized[3] == 13);
+  REQUIRE(resized[4] == 0);
+
+  // EncodePNG() quantizes the values in the same way.
+  std::string fromValues, fromResized;
+  mlboard::util::EncodePNG(values.memptr(), 5, 1, 1, fromValues);
+  mlboard::util::EncodePNG(resized.memptr(), 5, 1, 1, fromResized);
+  REQUIRE(fromValues == fromResized);
+
+  // Halving averages blocks of 2x2 pixels with both filters.
+  arma::mat image(4 * 4, 1);
+  for (size_t i = 0; i < image.n_elem; ++i)
+    image[i] = i * 10;
+  mlboard::util::ResizeImages(image, 4, 4, 1, 2, 2, ResizeFilter::Box,
+      resized);
+  REQUIRE(resized.n_rows == 4);
+  REQUIRE(resized[0] == 25);
+  REQUIRE(resized[1] == 45);
+  REQUIRE(resized[2] == 105);
+  REQUIRE(resized[3] == 125);
+  arma::Mat<unsigned char> bilinear;
+  mlboard::util::ResizeImages(image, 4, 4, 1, 2, 2, ResizeFilter::Bilinear,
+      bilinear);
+  for (size_t i = 0; i < resized.n_elem; ++i)
+    REQUIRE(bilinear[i] == resized[i]);
+
+  // The box filter weighs the covered part of every pixel.
+  arma::mat row(3, 1);
+  row[0] = 30;
+  row[1] = 60;
+  row[2] = 90;
+  mlboard::util::ResizeImages(row, 3, 1, 1, 2, 1, ResizeFilter::Box, resized);
+  REQUIRE(resized[0] == 40);
+  REQUIRE(resized[1] == 80);
+
+  // The bilinear filter interpolates between the pixel centers.
+  arma::mat pair(2, 1);
+  pair[0] = 0;
+  pair[1] = 100;
+  mlboard::util::ResizeImages(pair, 2, 1, 1, 4, 1, ResizeFilter::Bilinear,
+      resized);
+  REQUIRE(resized[0] == 0);
+  REQUIRE(resized[1] == 25);
+  REQUIRE(resized[2] == 75);
+  REQUIRE(resized[3] == 100);
+
+  // Channels are resized separately, and every column is an image.
+  arma::mat images(2 * 2 * 3, 9);
+  for (size_t j = 0; j < images.n_cols; ++j)
+  {
+    for (size_t i = 0; i < images.n_rows; ++i)
+      images(i, j) = (i % 3) * 100 + (i / 3) * 4 + j;
+  }
+  mlboard::util::ResizeImages(images, 2, 2, 3, 1, 1, ResizeFilter::Box,
+      resized);
+  REQUIRE(resized.n_rows == 3);
+  REQUIRE(resized.n_cols == 9);
+  for (size_t j = 0; j < images.n_cols; ++j)
+  {
+    REQUIRE(resized(0, j) == 6 + j);
+    REQUIRE(resized(1, j) == 106 + j);
+    REQUIRE(resized(2, j) == 206 + j);
+  }
+
+  REQUIRE_THROWS_AS(mlboard::util::ResizeImages(images, 2, 2, 2, 1, 1,
+      ResizeFilter::Box, resized), std::invalid_argument);
+  REQUIRE_THROWS_AS(mlboard::util::ResizeImages(images, 2, 2, 3, 0, 1,
+      ResizeFilter::Box, resized), std::invalid_argument);
+}
+
+/**
+ * Test that thumbnails fit in their size and keep the aspect ratio.
+ */
+TEST_CASE("Test ThumbnailSize", "[UtilFunction]")
+{
+  size_t width, height;
+  mlboard::util::ThumbnailSize(640, 480, 64, 64, width, height);
+  REQUIRE(width == 64);
+  REQUIRE(height == 48);
+  mlboard::util::ThumbnailSize(480, 640, 64, 64, width, height);
+  REQUIRE(width == 48);
+  REQUIRE(height == 64);
+  mlboard::util::ThumbnailSize(32, 16, 64, 64, width, height);
+  REQUIRE(width == 32);
+  REQUIRE(height == 16);
+  mlboard::util::ThumbnailSize(1000, 10, 64, 0, width, height);
+  REQUIRE(width == 64);
+  REQUIRE(height == 1);
+  mlboard::util::ThumbnailSize(100, 50, 0, 0, width, height);
+  REQUIRE(width == 100);
+  REQUIRE(height == 50);
 }